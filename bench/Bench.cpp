@@ -0,0 +1,276 @@
+#include "Disk.hpp"
+#include "Generator.hpp"
+#include "Sector.hpp"
+#include "Table.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string name;
+  std::uint64_t rows;
+  std::vector<double> seconds;
+  std::vector<std::pair<std::string, double>> metrics;
+  std::string error;
+};
+
+struct Options {
+  std::vector<std::uint64_t> rows;
+  int repetitions = 3;
+  std::uint64_t seed = 42;
+  fs::path output;
+  fs::path directory = fs::temp_directory_path() / "disco_bench";
+  DiskInfo geometry;
+};
+
+// Descarta lo que las consultas imprimen mientras se mide
+struct NullBuffer final : std::streambuf {
+  int overflow(int c) override {
+    return c;
+  }
+  std::streamsize xsputn(const char*, std::streamsize n) override {
+    return n;
+  }
+};
+
+struct MuteOutput {
+  NullBuffer null;
+  std::streambuf* previous = std::cout.rdbuf(&null);
+  ~MuteOutput() {
+    std::cout.rdbuf(previous);
+  }
+};
+
+void fresh_disk(const DiskInfo& geometry) {
+  buffer_manager.reset();
+  fs::remove_all(disk_path);
+  make_disk(geometry);
+}
+
+double elapsed(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <class Setup, class Run>
+Result measure(std::string name, std::uint64_t rows, int repetitions,
+               Setup&& setup, Run&& run) {
+  Result result{std::move(name), rows, {}, {}, {}};
+  for (int rep = 0; rep < repetitions; rep++) {
+    setup();
+    MuteOutput mute;
+    auto start = Clock::now();
+    run();
+    result.seconds.push_back(elapsed(start));
+  }
+  return result;
+}
+
+double median(std::vector<double> values) {
+  std::ranges::sort(values);
+  return values[values.size() / 2];
+}
+
+// Latencia de load_sector separando aciertos y fallos del buffer
+Result buffer_pattern(std::string pattern, std::uint64_t rows,
+                      std::uint64_t seed) {
+  auto total_sectors = global.total_sectors();
+  std::int64_t hot_sectors = BufferManager::capacity * global.block_size;
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<std::int64_t> any_sector(0, total_sectors - 1);
+  std::uniform_int_distribution<std::int64_t> hot_sector(0, hot_sectors - 1);
+
+  constexpr int accesses = 20'000;
+  double hit_time = 0, miss_time = 0;
+  int hit_count = 0, miss_count = 0;
+  auto bench_start = Clock::now();
+  for (int access = 0; access < accesses; access++) {
+    auto sector = pattern == "sequential" ? access % total_sectors
+                  : pattern == "random"   ? any_sector(rng)
+                                          : hot_sector(rng);
+    auto hits_before = buffer_manager.hit_count();
+    auto start = Clock::now();
+    buffer_manager.load_sector({sector});
+    auto seconds = elapsed(start);
+    if (buffer_manager.hit_count() > hits_before)
+      hit_time += seconds, hit_count++;
+    else
+      miss_time += seconds, miss_count++;
+  }
+
+  return {"buffer_" + pattern,
+          rows,
+          {elapsed(bench_start)},
+          {{"accesses", accesses},
+           {"hit_ratio", static_cast<double>(hit_count) / accesses},
+           {"hit_ns", hit_count ? hit_time * 1e9 / hit_count : 0},
+           {"miss_ns", miss_count ? miss_time * 1e9 / miss_count : 0}},
+          {}};
+}
+
+std::vector<Result> run_suite(const Options& options, std::uint64_t rows) {
+  std::vector<Result> results;
+  const std::string table = "bench_" + std::to_string(rows);
+  generate_csv(table + ".csv", rows, options.seed);
+  auto csv_bytes = static_cast<double>(fs::file_size(table + ".csv"));
+  auto no_setup = [] {};
+  auto new_disk = [&] {
+    fresh_disk(options.geometry);
+  };
+
+  try {
+    auto load = measure("load_csv", rows, options.repetitions, new_disk,
+                        [&] {
+                          load_csv(table);
+                        });
+    load.metrics = {{"rows_per_second", rows / median(load.seconds)},
+                    {"bytes_per_second", csv_bytes / median(load.seconds)}};
+    results.push_back(std::move(load));
+  } catch (const std::bad_alloc&) {
+    results.push_back({"load_csv", rows, {}, {}, "disk full"});
+    return results;
+  }
+
+  auto scan = measure("full_scan", rows, options.repetitions, no_setup, [&] {
+    select_all(table);
+  });
+  scan.metrics = {{"rows_per_second", rows / median(scan.seconds)}};
+  results.push_back(std::move(scan));
+
+  // El DNI generado es uniforme, el límite fija la selectividad
+  for (int percent : {1, 10, 50, 90}) {
+    auto limit = 10'000'000 + 900'000 * percent;
+    auto filtered = measure(
+        "filtered_scan_" + std::to_string(percent) + "pct", rows,
+        options.repetitions, no_setup, [&] {
+          select_all_where(table, "DNI < " + std::to_string(limit));
+        });
+    filtered.metrics = {{"selectivity", percent / 100.0},
+                        {"rows_per_second", rows / median(filtered.seconds)}};
+    results.push_back(std::move(filtered));
+  }
+
+  for (auto pattern : {"sequential", "random", "hot"})
+    results.push_back(buffer_pattern(pattern, rows, options.seed));
+
+  auto reload = [&] {
+    new_disk();
+    MuteOutput mute;
+    load_csv(table);
+  };
+  auto deleted = measure("delete_where_10pct", rows, options.repetitions,
+                         reload, [&] {
+                           delete_where(table, "DNI < 19000000");
+                         });
+  deleted.metrics = {{"rows_per_second", rows / median(deleted.seconds)}};
+  results.push_back(std::move(deleted));
+
+  fs::remove(table + ".csv");
+  return results;
+}
+
+void write_json(std::ostream& os, const Options& options,
+                const std::vector<Result>& results) {
+  os << "{\n  \"benchmark\": \"disco\",\n  \"seed\": " << options.seed
+     << ",\n  \"repetitions\": " << options.repetitions
+     << ",\n  \"geometry\": {\"plates\": " << global.plates
+     << ", \"tracks\": " << global.tracks << ", \"sectors\": " << global.sectors
+     << ", \"bytes\": " << global.bytes
+     << ", \"block_size\": " << global.block_size
+     << ", \"pool_capacity\": " << BufferManager::capacity
+     << "},\n  \"results\": [";
+  for (bool first = true; const auto& result : results) {
+    os << (first ? "\n" : ",\n") << "    {\"name\": \"" << result.name
+       << "\", \"rows\": " << result.rows;
+    first = false;
+    if (!result.error.empty()) {
+      os << ", \"error\": \"" << result.error << "\"}";
+      continue;
+    }
+    os << ", \"seconds\": [";
+    for (auto idx = 0uz; idx < result.seconds.size(); idx++)
+      os << (idx ? ", " : "") << result.seconds[idx];
+    os << "], \"median_seconds\": " << median(result.seconds);
+    for (const auto& [key, value] : result.metrics)
+      os << ", \"" << key << "\": " << value;
+    os << '}';
+  }
+  os << "\n  ]\n}\n";
+}
+
+void usage() {
+  std::cerr << "Uso: disco_bench [--rows N]... [--repetitions R] [--seed S]"
+               " [--output archivo.json] [--dir directorio]\n"
+               "                   [--plates N] [--tracks N] [--sectors N]"
+               " [--bytes N] [--block-size N]\n"
+               "     disco_bench generate FILAS archivo.csv [--seed S]\n";
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::string> args(argv + 1, argv + argc);
+  Options options;
+  std::vector<std::string> positional;
+  for (auto idx = 0uz; idx < args.size(); idx++) {
+    const auto& arg = args[idx];
+    bool has_value = idx + 1 < args.size();
+    if (arg == "--rows" && has_value)
+      options.rows.push_back(std::stoull(args[++idx]));
+    else if (arg == "--repetitions" && has_value)
+      options.repetitions = std::max(1, std::stoi(args[++idx]));
+    else if (arg == "--seed" && has_value)
+      options.seed = std::stoull(args[++idx]);
+    else if (arg == "--output" && has_value)
+      options.output = fs::absolute(args[++idx]);
+    else if (arg == "--dir" && has_value)
+      options.directory = fs::absolute(args[++idx]);
+    else if (auto field = geometry_option(options.geometry, arg);
+             field && has_value)
+      *field = std::stoi(args[++idx]);
+    else if (arg.starts_with("--")) {
+      usage();
+      return 1;
+    } else
+      positional.push_back(arg);
+  }
+
+  if (!positional.empty()) {
+    if (positional.size() != 3 || positional[0] != "generate") {
+      usage();
+      return 1;
+    }
+    generate_csv(positional[2], std::stoull(positional[1]), options.seed);
+    return 0;
+  }
+
+  if (options.rows.empty())
+    options.rows = {10'000};
+
+  // Todo se crea en un directorio aparte para no tocar el disco real
+  fs::create_directories(options.directory);
+  fs::current_path(options.directory);
+  disk_path = options.directory / "disk";
+
+  std::vector<Result> results;
+  for (auto rows : options.rows) {
+    std::clog << "Midiendo con " << rows << " filas\n";
+    auto suite = run_suite(options, rows);
+    results.insert(results.end(), std::make_move_iterator(suite.begin()),
+                   std::make_move_iterator(suite.end()));
+  }
+  buffer_manager.reset();
+  fs::remove_all(disk_path);
+
+  if (options.output.empty())
+    write_json(std::cout, options, results);
+  else {
+    std::ofstream file(options.output);
+    write_json(file, options, results);
+  }
+}
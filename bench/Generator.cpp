@@ -0,0 +1,63 @@
+#include "Generator.hpp"
+#include <array>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace {
+constexpr std::array<std::string_view, 24> surnames{
+    "Menendez", "Molina", "Escobar", "Carnero", "Teixeira", "Fernandez",
+    "Martinez", "Gomez", "Quiroga", "Cruz", "Iglesias", "Osorio", "Sanchez",
+    "Olaya", "Salgado", "Díaz", "Guerrero", "Câmara", "Pineda", "Maestas",
+    "Herrera", "Alvarez", "García", "Londoño"};
+
+constexpr std::array<std::string_view, 24> names{
+    "Maya", "Aarón", "Gregorio", "Camila", "Luna", "Teodoro", "Juan",
+    "Bautista", "Manuel", "Pedro", "Bento", "Felicitas", "Marcelo", "Anabel",
+    "Luana", "José", "Laura", "Benito", "Ximena", "Adán", "Oswaldo", "Alma",
+    "Lautaro", "Beatriz"};
+
+constexpr std::array<std::string_view, 12> schools{
+    "Química", "Biología", "Matemáticas", "Física", "Medicina Humana",
+    "Derecho", "Psicología", "Arquitectura", "Ingeniería Civil", "Contabilidad",
+    "Historia", "Ingeniería de Sistemas"};
+} // namespace
+
+void generate_csv(const std::filesystem::path& path, std::uint64_t rows,
+                  std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<std::int64_t> dni(10'000'000, 99'999'999);
+  std::uniform_int_distribution<std::int64_t> year(2017, 2025);
+  std::uniform_int_distribution<std::int64_t> code(0, 9'999);
+  std::uniform_int_distribution<std::size_t> surname(0, surnames.size() - 1);
+  std::uniform_int_distribution<std::size_t> name(0, names.size() - 1);
+  std::uniform_int_distribution<std::size_t> school(0, schools.size() - 1);
+
+  std::ofstream file(path, std::ios::binary);
+  file << "DNI#INT,Nombre#STRING,CUI#INT,Escuela#STRING\n";
+
+  // Las filas se acumulan y se escriben en bloques grandes
+  std::string buffer;
+  for (std::uint64_t row = 0; row < rows; row++) {
+    buffer += std::to_string(dni(rng));
+    buffer += ",\"";
+    buffer += surnames[surname(rng)];
+    buffer += ' ';
+    buffer += surnames[surname(rng)];
+    buffer += ' ';
+    buffer += names[name(rng)];
+    buffer += ' ';
+    buffer += names[name(rng)];
+    buffer += "\",";
+    buffer += std::to_string(year(rng) * 10'000 + code(rng));
+    buffer += ",\"";
+    buffer += schools[school(rng)];
+    buffer += "\"\n";
+    if (buffer.size() >= 1 << 20) {
+      file.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+  }
+  file.write(buffer.data(), buffer.size());
+}
@@ -0,0 +1,12 @@
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include <cstdint>
+#include <filesystem>
+
+// Escribe un CSV con el mismo esquema que unsa.csv (DNI, Nombre, CUI,
+// Escuela) y rows filas; la misma semilla genera siempre el mismo archivo
+void generate_csv(const std::filesystem::path& path, std::uint64_t rows,
+                  std::uint64_t seed);
+
+#endif
@@ -0,0 +1,140 @@
+#include "Protocol.hpp"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+int connect_to(const std::string& path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+    throw std::runtime_error("Ruta del socket demasiado larga");
+  std::strcpy(address.sun_path, path.c_str());
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                          sizeof(address)) < 0)
+    throw std::system_error(errno, std::generic_category(), path);
+  return fd;
+}
+
+void send_all(int fd, std::string_view data) {
+  while (!data.empty()) {
+    auto sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR)
+      continue;
+    if (sent < 0)
+      throw std::system_error(errno, std::generic_category(), "send");
+    data.remove_prefix(sent);
+  }
+}
+
+// Lee del socket línea por línea
+class LineReader {
+  int fd;
+  std::string buffer;
+
+public:
+  explicit LineReader(int _fd) : fd{_fd} {}
+
+  std::optional<std::string> next() {
+    std::array<char, 1 << 16> chunk;
+    auto end = buffer.find('\n');
+    while (end == std::string::npos) {
+      auto received = ::recv(fd, chunk.data(), chunk.size(), 0);
+      if (received < 0 && errno == EINTR)
+        continue;
+      if (received <= 0)
+        return std::nullopt;
+      buffer.append(chunk.data(), received);
+      end = buffer.find('\n');
+    }
+    auto line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    return line;
+  }
+};
+
+// Muestra una respuesta completa y devuelve si la sentencia tuvo éxito,
+// o nullopt si el servidor cerró la conexión antes de terminarla
+std::optional<bool> print_response(LineReader& reader) {
+  while (auto line = reader.next()) {
+    if (*line == Protocol::ok)
+      return true;
+    if (*line == Protocol::failed)
+      return false;
+    auto text = line->size() > 2 ? line->substr(2) : std::string();
+    if ((*line)[0] == Protocol::output)
+      std::cout << text << '\n';
+    else if ((*line)[0] == Protocol::notice)
+      std::clog << text << '\n';
+    else
+      std::cerr << text << '\n';
+  }
+  return std::nullopt;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string socket_path{Protocol::default_socket};
+  for (int idx = 1; idx < argc; idx += 2) {
+    if (std::string_view(argv[idx]) != "--socket" || idx + 1 == argc) {
+      std::cerr << "Uso: disco_client [--socket ruta]\n";
+      return 1;
+    }
+    socket_path = argv[idx + 1];
+  }
+
+  int fd;
+  try {
+    fd = connect_to(socket_path);
+  } catch (const std::exception& e) {
+    std::cerr << "No se pudo conectar: " << e.what() << '\n';
+    return 1;
+  }
+  LineReader reader(fd);
+  int failures = 0;
+
+  if (::isatty(STDIN_FILENO)) {
+    std::string line;
+    // Como el intérprete: una sentencia por vez, con prompt
+    while (std::clog << "  > ", std::getline(std::cin, line)) {
+      send_all(fd, line + '\n');
+      auto succeeded = print_response(reader);
+      if (!succeeded) {
+        std::cerr << "El servidor cerró la conexión\n";
+        return 1;
+      }
+      failures += !*succeeded;
+    }
+    std::clog << std::endl;
+  } else {
+    // Sin terminal se envían todas las líneas sin esperar las respuestas,
+    // el servidor las responde en orden
+    std::jthread sender([fd] {
+      std::string line;
+      try {
+        while (std::getline(std::cin, line))
+          send_all(fd, line + '\n');
+      } catch (const std::system_error&) {
+        // El servidor cerró, el lector lo informa
+      }
+      ::shutdown(fd, SHUT_WR);
+    });
+    while (true) {
+      auto succeeded = print_response(reader);
+      if (!succeeded)
+        break;
+      failures += !*succeeded;
+    }
+  }
+  ::close(fd);
+  return failures ? 1 : 0;
+}
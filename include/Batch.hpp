@@ -0,0 +1,26 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "BufferManager.hpp"
+#include "Command.hpp"
+#include <iosfwd>
+
+struct BatchOptions {
+  // Si es falso se detiene en la primera sentencia con error
+  bool continue_on_error = false;
+  // Imprime en std::clog cuánto tardó cada sentencia
+  bool timings = false;
+  // Lecturas que se ejecutan a la vez. Cada recorrido fija hasta dos
+  // bloques, no se admiten más de las que entran en el buffer
+  int jobs = (BufferManager::capacity - 1) / 2;
+};
+
+// Ejecuta las líneas de input sin mostrar el prompt. Las líneas vacías y
+// las que empiezan con -- se ignoran. Los SELECT consecutivos que lo
+// permiten se ejecutan a la vez, el resto espera a que terminen todas
+// las anteriores. La salida y los errores de cada sentencia se escriben
+// en el orden del script. Devuelve cuántas sentencias fallaron
+int run_batch(std::istream& input, Session& session,
+              const BatchOptions& options);
+
+#endif
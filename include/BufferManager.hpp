@@ -1,38 +1,203 @@
 #ifndef BUFFER_MANAGER_HPP
 #define BUFFER_MANAGER_HPP
 
+#include "Compression.hpp"
 #include "Disk.hpp"
-#include <list>
-#include <unordered_map>
+#include "IoScheduler.hpp"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
 
+// Descriptor de un marco del buffer, sus datos viven en la arena
 struct Frame {
-  std::string content;
+  std::int64_t block_id = -1;
   bool dirty_bit = false;
   int pin_count = 0;
+  // Accesos desde que se cargó, se guardan al cerrar para el
+  // precalentamiento del próximo arranque
+  std::int64_t accesses = 0;
+  // Vecinos en la lista MRU (índices de marco, -1 en los extremos)
+  int newer = -1;
+  int older = -1;
+};
 
-  Frame(Frame&&) = default;
-  Frame& operator=(Frame&&) = default;
+// Tabla de páginas de tamaño fijo con direccionamiento abierto: bloque
+// -> marco. Al no reservar nodos, un fallo no pide memoria al sistema
+template <int Frames>
+class PageTable {
+  static constexpr int slots = std::bit_ceil(2u * Frames);
+  struct Entry {
+    std::int64_t block_id = -1;
+    int frame = -1;
+  };
+  std::array<Entry, slots> entries;
 
-  Frame(int frame_id);
-  template <bool Readonly = true>
-  auto data(this std::conditional_t<Readonly, const Frame&, Frame&> self);
+  static int home(std::int64_t block_id) {
+    return static_cast<int>(static_cast<std::uint64_t>(block_id) *
+                                0x9E3779B97F4A7C15ull >>
+                            (64 - std::countr_zero(unsigned{slots})));
+  }
+  int slot_of(std::int64_t block_id) const {
+    for (int slot = home(block_id);; slot = (slot + 1) % slots)
+      if (entries[slot].block_id == block_id || entries[slot].block_id < 0)
+        return slot;
+  }
+
+public:
+  // Marco que contiene el bloque, o -1
+  int find(std::int64_t block_id) const {
+    return entries[slot_of(block_id)].frame;
+  }
+  void insert(std::int64_t block_id, int frame) {
+    entries[slot_of(block_id)] = {block_id, frame};
+  }
+  // Borrado con corrimiento hacia atrás, sin marcas de borrado
+  void erase(std::int64_t block_id) {
+    int hole = slot_of(block_id);
+    if (entries[hole].block_id < 0)
+      return;
+    for (int slot = (hole + 1) % slots; entries[slot].block_id >= 0;
+         slot = (slot + 1) % slots) {
+      int wanted = home(entries[slot].block_id);
+      bool movable = hole <= slot ? wanted <= hole || wanted > slot
+                                  : wanted <= hole && wanted > slot;
+      if (movable) {
+        entries[hole] = entries[slot];
+        hole = slot;
+      }
+    }
+    entries[hole] = {};
+  }
+  void clear() {
+    entries.fill({});
+  }
 };
 
+// Contadores acumulados del buffer, la diferencia entre dos lecturas
+// es el trabajo hecho en ese intervalo
+struct BufferStats {
+  std::int64_t accesses = 0;
+  std::int64_t hits = 0;
+  std::int64_t bytes_read = 0;
+  std::int64_t bytes_written = 0;
+
+  std::int64_t misses() const {
+    return accesses - hits;
+  }
+  BufferStats& operator+=(const BufferStats& other) {
+    accesses += other.accesses;
+    hits += other.hits;
+    bytes_read += other.bytes_read;
+    bytes_written += other.bytes_written;
+    return *this;
+  }
+  BufferStats operator-(const BufferStats& other) const {
+    return {accesses - other.accesses, hits - other.hits,
+            bytes_read - other.bytes_read, bytes_written - other.bytes_written};
+  }
+};
+
+// Buffer de bloques del disco. Los datos de todos los marcos están en
+// una arena alineada a página que se reserva en el primer acceso (la
+// geometría recién se conoce al abrir el disco), así los fallos no
+// reservan memoria y los marcos se pueden leer con O_DIRECT. Los
+// sectores de un bloque pueden transferirse en paralelo, uno por plato.
+// Los marcos siempre están sin comprimir: la compresión se aplica solo
+// al leer y escribir, pasando por un bloque extra al final de la arena.
+// Se puede usar desde varios hilos: un mutex protege los descriptores
+// de los marcos (también durante la E/S de un fallo), y los datos de
+// un bloque fijado no cambian de marco hasta el unpin
 class BufferManager {
-  int hits = 0;
-  int total_access = 0;
-  std::unordered_map<int, Frame> pool;
-  std::list<int> mru;
+public:
+  static constexpr int capacity = 8;
+  static constexpr std::size_t frame_alignment = 4096;
+
+private:
+  struct AlignedDelete {
+    void operator()(char* arena) const {
+      ::operator delete[](arena, std::align_val_t{frame_alignment});
+    }
+  };
+
+  mutable std::mutex mutex;
+  BufferStats counters;
+  std::unique_ptr<char[], AlignedDelete> arena;
+  // Se crea junto con la arena si hay más de un plato
+  std::unique_ptr<IoScheduler> scheduler;
+  std::unique_ptr<ExtentMap> extents;
+  // Hilo que vuelve a cargar los bloques del arranque anterior. Solo él
+  // toca los marcos hasta que termina, fetch lo espera antes de seguir
+  // (con el mutex tomado, así lo espera un solo hilo)
+  std::jthread warmer;
+  std::array<Frame, capacity> frames;
+  PageTable<capacity> page_table;
+  int mru_head = -1;
+  int resident = 0;
+
+  char* frame_data(int frame) const {
+    return arena.get() +
+           static_cast<std::size_t>(frame) * global.block_size * global.bytes;
+  }
+  char* staging() const {
+    return frame_data(capacity);
+  }
+  void transfer_block(std::int64_t block_id, char* data, int sectors,
+                      bool write);
+  void allocate();
+  // Lee el bloque del marco desde el disco, devuelve los bytes leídos
+  std::int64_t load_frame(int frame);
+  void read_frame(int frame);
+  void write_frame(int frame);
+  void unlink(int frame);
+  void push_front(int frame);
+  void finish_warm_up() {
+    if (warmer.joinable())
+      warmer.join();
+  }
+  void warm_up(std::stop_token stop, std::vector<std::int64_t> blocks);
+  // Trae el bloque al buffer si no está y lo deja como el más reciente,
+  // devuelve el índice de su marco
+  int fetch(std::int64_t block_id);
 
 public:
+  // Al destruirse escribe los marcos sucios y guarda en disk/warm los
+  // bloques residentes con sus accesos
   ~BufferManager();
-  static constexpr int capacity = 8;
+  // Empieza a cargar en segundo plano los bloques que estaban en el
+  // buffer al cerrar la última vez, los más accedidos primero
+  void start_warm_up();
+  // El puntero devuelto no está fijado: otro hilo puede reemplazar el
+  // bloque en cualquier momento, así que solo sirve si nadie más está
+  // usando el buffer. Con varios hilos hay que usar pin_sector
   template <bool Readonly = true>
   std::conditional_t<Readonly, const char*, char*>
   load_sector(Address sector_address);
-  void pin(Address sector_address);
+  // Como load_sector, pero además fija el bloque: el puntero
+  // devuelto es válido hasta el unpin correspondiente
+  template <bool Readonly = true>
+  std::conditional_t<Readonly, const char*, char*>
+  pin_sector(Address sector_address);
   void unpin(Address sector_address);
-  void print() const;
+  void print();
+  std::int64_t hit_count() const {
+    return stats().hits;
+  }
+  std::int64_t access_count() const {
+    return stats().accesses;
+  }
+  BufferStats stats() const {
+    std::lock_guard lock(mutex);
+    return counters;
+  }
+  // Descarta todos los marcos sin escribirlos, para cuando el
+  // disco se vuelve a crear desde cero (la arena se vuelve a
+  // reservar con la geometría nueva)
+  void reset();
 };
 
 #endif
@@ -0,0 +1,45 @@
+#ifndef COMMAND_HPP
+#define COMMAND_HPP
+
+#include "Statement.hpp"
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Lo que se conserva entre las sentencias de una misma entrada
+struct Session {
+  PlanCache plan_cache;
+  std::unordered_map<std::string, std::unique_ptr<Statement>> prepared;
+};
+
+// SELECT o DELETE de la línea, tomado del caché de planes o analizado
+// y guardado en él. nullptr si la línea no es uno o tiene un error (que
+// ya se informó)
+std::shared_ptr<const Statement> cached_statement(Session& session,
+                                                  std::string_view line);
+
+// Ejecuta una línea, sentencia o comando. Los registros y resultados se
+// escriben en out, los errores en errors() y los avisos en notices().
+// Los errores de análisis se lanzan como excepciones
+void run_command(std::string_view line, Session& session, std::ostream& out);
+
+// Lo que produjo una sentencia, guardado hasta que le toca mostrarse
+struct CommandResult {
+  std::string line;
+  std::string output;
+  std::string notices;
+  std::string errors;
+  double seconds = 0;
+  bool failed = false;
+};
+
+// Ejecuta run en el hilo actual capturando su salida, sus avisos y sus
+// errores. La sentencia falló si lanzó una excepción o escribió algún
+// error
+CommandResult capture_command(
+    std::string line, const std::function<void(std::ostream&)>& run);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Comprime un bloque con codificación de corridas de ceros: los
+// registros tienen cadenas de largo fijo rellenas con ceros y mapas de
+// ocupación casi vacíos. El resultado lleva una cabecera con su tamaño.
+// Devuelve los bytes escritos, o 0 si no entra en output
+std::size_t compress_block(std::span<const char> input, std::span<char> output);
+
+// Inversa de compress_block, output debe tener el tamaño del bloque
+// original. Lanza si los datos no son un bloque comprimido válido
+void decompress_block(std::span<const char> input, std::span<char> output);
+
+// Sectores que ocupa en el disco cada bloque, guardado en disk/extents
+// con una entrada por bloque (0 = sin comprimir). Sin este mapa no se
+// sabría cuántos sectores leer ni si el bloque tiene cabecera
+class ExtentMap {
+  std::vector<std::uint16_t> stored;
+  int file = -1;
+
+public:
+  // Abre o crea el mapa del disco abierto
+  ExtentMap();
+  ExtentMap(const ExtentMap&) = delete;
+  ~ExtentMap();
+
+  int stored_sectors(std::int64_t block_id) const;
+  // Se llama después de escribir los sectores del bloque
+  void set(std::int64_t block_id, int sectors);
+};
+
+#endif
@@ -1,27 +1,60 @@
 #ifndef DISK_HPP
 #define DISK_HPP
 
+#include <cstdint>
 #include <filesystem>
+#include <span>
+#include <string_view>
 namespace fs = std::filesystem;
-const static inline auto disk_path = fs::current_path() / "disk";
+inline fs::path disk_path = fs::current_path() / "disk";
 
 struct DiskInfo {
-  int plates;
-  int tracks;
-  int sectors;
-  int bytes;
-  int block_size;
+  int plates = 4;
+  int tracks = 16;
+  int sectors = 64;
+  int bytes = 512;
+  int block_size = 8;
+
+  std::int64_t total_sectors() const {
+    return std::int64_t{plates} * 2 * tracks * sectors;
+  }
+  std::int64_t total_bytes() const {
+    return total_sectors() * bytes;
+  }
 };
 
-static constexpr DiskInfo global = {4, 16, 64, 512, 8};
+// Geometría del disco abierto, se fija al crearlo o al leer su superbloque
+inline DiskInfo global;
+
+// Posición física de un sector en el disco
+struct SectorLocation {
+  long long plate;
+  long long surface;
+  long long track;
+  long long sector;
+};
 
 struct Address {
-  int address;
+  std::int64_t address;
   bool operator==(const Address&) const = default;
+  // Los sectores consecutivos se reparten entre los platos, luego
+  // avanzan por la pista, la pista y la superficie
+  SectorLocation location() const;
   fs::path to_path() const;
+  // Escribe la misma ruta en buffer sin reservar memoria, devuelve
+  // false si no cabe
+  bool format_path(std::span<char> buffer) const;
 };
 static constexpr Address NullAddress = {-1};
 
-void make_disk();
+// Campo de la geometría que corresponde a una opción de línea de comandos
+// (--plates, --tracks, --sectors, --bytes, --block-size), o nullptr
+int* geometry_option(DiskInfo& info, std::string_view option);
+
+// Crea el disco con la geometría indicada y la guarda en su superbloque
+void make_disk(const DiskInfo& info = {});
+
+// Lee la geometría del superbloque de un disco existente
+void open_disk();
 
 #endif
@@ -0,0 +1,37 @@
+#ifndef ERRORS_HPP
+#define ERRORS_HPP
+
+#include <iostream>
+#include <utility>
+
+// Flujo de los mensajes de error del hilo actual. Es std::cerr salvo
+// dentro de un StreamCapture, que los guarda para mostrarlos junto con
+// la salida de su sentencia y para saber si la sentencia falló
+inline thread_local std::ostream* error_output = nullptr;
+
+inline std::ostream& errors() {
+  return error_output ? *error_output : std::cerr;
+}
+
+// Lo mismo para los avisos de los comandos, que van a std::clog
+inline thread_local std::ostream* notice_output = nullptr;
+
+inline std::ostream& notices() {
+  return notice_output ? *notice_output : std::clog;
+}
+
+// Redirige uno de los flujos del hilo actual mientras existe
+class StreamCapture {
+  std::ostream*& target;
+  std::ostream* previous;
+
+public:
+  StreamCapture(std::ostream*& _target, std::ostream& os) :
+      target{_target}, previous{std::exchange(_target, &os)} {}
+  StreamCapture(const StreamCapture&) = delete;
+  ~StreamCapture() {
+    target = previous;
+  }
+};
+
+#endif
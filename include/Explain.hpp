@@ -0,0 +1,86 @@
+#ifndef EXPLAIN_HPP
+#define EXPLAIN_HPP
+
+#include "BufferManager.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Prefijo EXPLAIN de una consulta: solo mostrar el plan, o
+// ejecutarla midiendo cada etapa (ANALYZE)
+enum class Explain { None, Plan, Analyze };
+
+// Etapa del plan de ejecución y lo que se midió en ella
+struct PlanStage {
+  std::string description;
+  std::vector<std::string> details;
+  std::vector<std::size_t> inputs;
+  double seconds = 0;
+  std::int64_t rows_examined = 0;
+  std::int64_t rows_emitted = 0;
+  std::int64_t sectors = 0;
+  BufferStats buffer;
+};
+
+// Plan de una consulta. Las etapas se ejecutan intercaladas (el
+// recorrido le entrega filas al ordenamiento, que se las entrega a la
+// salida), así que con ANALYZE cada cambio de etapa cierra la medición
+// de tiempo y E/S de la anterior y la atribuye a esa etapa
+class QueryPlan {
+  using Clock = std::chrono::steady_clock;
+  static constexpr auto no_stage = static_cast<std::size_t>(-1);
+
+  Explain mode;
+  std::vector<PlanStage> stages;
+  std::size_t active = no_stage;
+  Clock::time_point since;
+  BufferStats since_buffer;
+  Clock::time_point started = Clock::now();
+
+  void print_stage(std::ostream& os, std::size_t stage, int depth) const;
+
+public:
+  explicit QueryPlan(Explain _mode) : mode{_mode} {}
+
+  // Con EXPLAIN sin ANALYZE la consulta no se ejecuta
+  bool executes() const {
+    return mode != Explain::Plan;
+  }
+  bool analyzing() const {
+    return mode == Explain::Analyze;
+  }
+  bool explaining() const {
+    return mode != Explain::None;
+  }
+
+  // Agrega una etapa que consume las filas de inputs, la última
+  // etapa agregada es la raíz del plan
+  std::size_t add(std::string description,
+                  std::vector<std::size_t> inputs = {});
+  PlanStage& operator[](std::size_t stage) {
+    return stages[stage];
+  }
+
+  // Activa stage y devuelve la etapa que estaba activa
+  std::size_t enter(std::size_t stage);
+  void print(std::ostream& os) const;
+};
+
+// Mantiene activa una etapa del plan mientras existe
+class StageScope {
+  QueryPlan& plan;
+  std::size_t previous;
+
+public:
+  StageScope(QueryPlan& _plan, std::size_t stage) :
+      plan{_plan},
+      previous{_plan.enter(stage)} {}
+  StageScope(const StageScope&) = delete;
+  ~StageScope() {
+    plan.enter(previous);
+  }
+};
+
+#endif
@@ -2,17 +2,45 @@
 #define INTERPRETER_HPP
 
 #include "Type.hpp"
+#include <iosfwd>
 #include <memory>
+#include <optional>
 #include <span>
+#include <string_view>
+#include <vector>
 
 namespace Db {
 
 struct Node {
   virtual ~Node() = default;
   virtual Value evaluate(const char*, const Column*) const = 0;
+  // Escribe el subárbol con paréntesis explícitos, para EXPLAIN
+  virtual void print(std::ostream&, const Column*) const = 0;
 };
 using NodePtr = std::unique_ptr<Node>;
-NodePtr parseExpression(std::string_view, std::span<const Column>);
+
+// Columnas de una tabla dentro de una consulta con varias tablas,
+// sus registros se evalúan concatenados en el orden de los esquemas
+struct Schema {
+  std::string_view table;
+  std::span<const Column> columns;
+};
+
+// Índice de la columna (nombre o tabla.nombre) dentro de
+// la concatenación de los esquemas
+std::optional<std::size_t> findColumn(std::span<const Schema>,
+                                      std::string_view);
+// Valores de los marcadores $1, $2... de una sentencia preparada
+using Parameters = std::vector<Value>;
+
+// Los marcadores solo se aceptan si se pasan parameters, el árbol lee
+// sus valores de ahí cada vez que se evalúa
+NodePtr parseExpression(std::string_view, std::span<const Column>,
+                        const Parameters* parameters = nullptr);
+NodePtr parseExpression(std::string_view, std::span<const Schema>,
+                        const Parameters* parameters = nullptr);
+// Un literal suelto: número, "cadena", true o false
+Value parseLiteral(std::string_view);
 } // namespace Db
 
 #endif
@@ -0,0 +1,65 @@
+#ifndef IO_SCHEDULER_HPP
+#define IO_SCHEDULER_HPP
+
+#include "Disk.hpp"
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Lee o escribe un sector completo desde el hilo que llama. Con
+// direct_io se intenta primero con O_DIRECT
+void transfer_sector(Address sector_address, char* data, bool write);
+
+// Grupo de peticiones que se esperan juntas, como los sectores de un
+// bloque. El primer error se vuelve a lanzar en wait
+class IoBatch {
+  std::mutex mutex;
+  std::condition_variable finished;
+  int pending = 0;
+  std::exception_ptr error;
+
+public:
+  void add();
+  void complete(std::exception_ptr failure = nullptr);
+  void wait();
+};
+
+struct IoRequest {
+  Address address;
+  char* data;
+  bool write;
+  IoBatch* batch;
+};
+
+// Planificador de E/S con una cola y un hilo por plato (cada plato es
+// un directorio que puede estar en otro dispositivo), así los sectores
+// de un bloque, que están repartidos entre los platos, se transfieren
+// en paralelo. Cada hilo atiende su cola como un ascensor: sigue en la
+// dirección actual por número de pista y solo se da vuelta cuando no
+// quedan peticiones más adelante
+class IoScheduler {
+  struct Queue {
+    std::mutex mutex;
+    std::condition_variable_any ready;
+    std::vector<IoRequest> pending;
+    long long head_track = 0;
+    bool ascending = true;
+    std::jthread worker;
+  };
+  std::vector<std::unique_ptr<Queue>> queues;
+
+  static IoRequest next_request(Queue& queue);
+  static void serve(std::stop_token stop, Queue& queue);
+
+public:
+  explicit IoScheduler(int plates);
+  IoScheduler(const IoScheduler&) = delete;
+  ~IoScheduler();
+
+  void submit(const IoRequest& request);
+};
+
+#endif
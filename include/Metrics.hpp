@@ -0,0 +1,145 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+class MetricRegistry;
+
+// Contador monótono, se puede incrementar desde varios hilos
+class Counter {
+  std::atomic<std::int64_t> value = 0;
+
+public:
+  const std::string_view name;
+  const std::string_view help;
+
+  Counter(MetricRegistry& registry, std::string_view _name,
+          std::string_view _help);
+  void add(std::int64_t amount = 1) {
+    value.fetch_add(amount, std::memory_order_relaxed);
+  }
+  std::int64_t get() const {
+    return value.load(std::memory_order_relaxed);
+  }
+};
+
+// Valor que se calcula recién al exportar, a partir de otros contadores
+class SampledMetric {
+public:
+  const std::string_view name;
+  const std::string_view help;
+  const std::string_view type;
+  double (*const sample)();
+
+  SampledMetric(MetricRegistry& registry, std::string_view _name,
+                std::string_view _help, std::string_view _type,
+                double (*_sample)());
+};
+
+// Histograma de duraciones con cubetas exponenciales: la cubeta i
+// cuenta lo que tardó hasta 2^i µs, la última no tiene límite
+class Histogram {
+  static constexpr int bucket_count = 32;
+  std::array<std::atomic<std::int64_t>, bucket_count + 1> buckets{};
+  std::atomic<std::int64_t> count = 0;
+  std::atomic<std::int64_t> sum_ns = 0;
+
+public:
+  const std::string_view name;
+  const std::string_view help;
+
+  Histogram(MetricRegistry& registry, std::string_view _name,
+            std::string_view _help);
+  void observe(double seconds);
+
+  static constexpr int size() {
+    return bucket_count + 1;
+  }
+  // Límite superior de la cubeta en segundos, infinito en la última
+  static double upper_bound(int bucket);
+  std::int64_t bucket(int idx) const {
+    return buckets[idx].load(std::memory_order_relaxed);
+  }
+  std::int64_t total() const {
+    return count.load(std::memory_order_relaxed);
+  }
+  double sum() const {
+    return sum_ns.load(std::memory_order_relaxed) / 1e9;
+  }
+  // Estimación interpolando dentro de la cubeta que contiene el cuantil
+  double quantile(double q) const;
+};
+
+// Mide desde su creación y lo registra en el histograma al destruirse
+class LatencyTimer {
+  Histogram& histogram;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+public:
+  explicit LatencyTimer(Histogram& _histogram) : histogram{_histogram} {}
+  LatencyTimer(const LatencyTimer&) = delete;
+  ~LatencyTimer() {
+    histogram.observe(std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count());
+  }
+};
+
+class MetricRegistry {
+  friend Counter;
+  friend SampledMetric;
+  friend Histogram;
+
+  std::vector<const Counter*> counters;
+  std::vector<const SampledMetric*> sampled;
+  std::vector<const Histogram*> histograms;
+
+public:
+  MetricRegistry() = default;
+  MetricRegistry(const MetricRegistry&) = delete;
+
+  // Resumen legible para el comando STATS
+  void print(std::ostream& os) const;
+  // Formato de texto de Prometheus
+  void write_prometheus(std::ostream& os) const;
+};
+
+// Métricas del motor. Las del buffer que ya cuenta BufferManager se
+// muestrean al exportar en vez de contarse dos veces
+struct Metrics : MetricRegistry {
+  Counter buffer_evictions{*this, "disco_buffer_evictions_total",
+                           "Marcos desalojados del buffer"};
+  Counter buffer_writebacks{*this, "disco_buffer_writebacks_total",
+                            "Marcos sucios escritos al disco"};
+  Counter allocations{*this, "disco_sector_allocations_total",
+                      "Sectores entregados por allocate_sector"};
+  Counter allocation_scans{
+      *this, "disco_allocation_scanned_sectors_total",
+      "Sectores revisados buscando uno libre al asignar"};
+  Counter rows_scanned{*this, "disco_rows_scanned_total",
+                       "Registros vivos leídos por recorridos secuenciales"};
+  Counter versions_pruned{
+      *this, "disco_dead_versions_pruned_total",
+      "Versiones borradas que ya nadie veía y se reutilizaron o descartaron"};
+  Counter plan_cache_hits{*this, "disco_plan_cache_hits_total",
+                          "Sentencias tomadas ya analizadas del caché"};
+  Counter plan_cache_misses{*this, "disco_plan_cache_misses_total",
+                            "Sentencias que hubo que analizar"};
+  Histogram miss_latency{*this, "disco_buffer_miss_seconds",
+                         "Tiempo de leer un bloque del disco en un fallo"};
+  Histogram scan_latency{*this, "disco_scan_seconds",
+                         "Duración de los recorridos secuenciales"};
+  Histogram query_latency{*this, "disco_query_seconds",
+                          "Duración de las sentencias"};
+};
+
+inline Metrics metrics;
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "Disk.hpp"
+#include "Explain.hpp"
+#include "Type.hpp"
+#include <cstddef>
+#include <iosfwd>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Las consultas se ejecutan como una tubería de empuje. Un productor
+// es un invocable que recibe al consumidor de la etapa siguiente y le
+// entrega lotes de registros hasta agotarse, o hasta que el consumidor
+// devuelve false (un LIMIT alcanzado). Cada operador envuelve a su
+// productor, así todas las etapas corren dentro de un solo recorrido
+// sin copiar los registros de una a otra
+
+// Registros que una etapa le entrega a la siguiente. Los punteros
+// solo son válidos durante la llamada al consumidor
+struct RecordBatch {
+  // Sector del que salen los registros, NullAddress si no salen
+  // directamente de una tabla (un join, un ordenamiento)
+  Address sector = NullAddress;
+  std::span<const char* const> records;
+};
+
+// Deja pasar solo los registros que cumplen el predicado
+template <class Source, class Predicate>
+auto filter_operator(Source source, Predicate predicate, QueryPlan& plan,
+                     std::size_t stage) {
+  return [source = std::move(source), predicate = std::move(predicate),
+          &plan, stage](auto&& consume) mutable {
+    std::vector<const char*> selected;
+    source([&](const RecordBatch& batch) {
+      StageScope scope(plan, stage);
+      selected.clear();
+      for (auto record : batch.records)
+        if (predicate(record))
+          selected.push_back(record);
+      plan[stage].rows_examined += batch.records.size();
+      plan[stage].rows_emitted += selected.size();
+      return selected.empty() || consume(RecordBatch{batch.sector, selected});
+    });
+  };
+}
+
+// Copia algunas columnas de cada registro a un registro nuevo
+class Projection {
+  // Posición y tamaño de cada columna elegida en el registro original
+  std::vector<std::pair<std::size_t, std::size_t>> fields;
+  std::size_t record_size = 0;
+  std::vector<char> buffer;
+  std::vector<const char*> records;
+
+public:
+  Projection(std::span<const Db::Column> columns,
+             std::span<const std::size_t> selected);
+  // Los registros del lote devuelto viven hasta la siguiente llamada
+  RecordBatch apply(const RecordBatch& batch);
+};
+
+template <class Source>
+auto project_operator(Source source, Projection projection, QueryPlan& plan,
+                      std::size_t stage) {
+  return [source = std::move(source), projection = std::move(projection),
+          &plan, stage](auto&& consume) mutable {
+    source([&](const RecordBatch& batch) {
+      StageScope scope(plan, stage);
+      plan[stage].rows_examined += batch.records.size();
+      plan[stage].rows_emitted += batch.records.size();
+      return consume(projection.apply(batch));
+    });
+  };
+}
+
+// Escribe cada registro en una línea con los campos separados por #
+void print_record(std::ostream& os, const char* record,
+                  std::span<const Db::Column> columns);
+
+// Último consumidor de un SELECT: imprime los registros y corta la
+// tubería al llegar al límite. Con ANALYZE solo los cuenta
+class OutputSink {
+  std::ostream& out;
+  std::span<const Db::Column> columns;
+  QueryPlan& plan;
+  std::size_t stage;
+  std::size_t remaining;
+
+public:
+  OutputSink(std::ostream& _out, std::span<const Db::Column> _columns,
+             QueryPlan& _plan, std::size_t _stage, std::size_t limit) :
+      out{_out},
+      columns{_columns},
+      plan{_plan},
+      stage{_stage},
+      remaining{limit} {}
+
+  bool operator()(const RecordBatch& batch);
+};
+
+#endif
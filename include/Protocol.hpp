@@ -0,0 +1,41 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <string>
+#include <string_view>
+
+// Protocolo entre disco --serve y disco_client, en líneas de texto. El
+// cliente envía una sentencia por línea. El servidor responde cada una,
+// en el orden en que llegaron, con las líneas que produjo precedidas por
+// el flujo al que pertenecen, y cierra la respuesta con una línea de
+// estado
+namespace Protocol {
+inline constexpr std::string_view default_socket = "disco.sock";
+
+// Prefijos de las líneas de una respuesta
+inline constexpr char output = 'R';
+inline constexpr char notice = 'I';
+inline constexpr char error = 'E';
+
+// Líneas de estado
+inline constexpr std::string_view ok = "OK";
+inline constexpr std::string_view failed = "ERROR";
+
+// Agrega a wire cada línea de text con el prefijo de su flujo
+inline void append_lines(std::string& wire, char stream,
+                         std::string_view text) {
+  while (!text.empty()) {
+    auto end = text.find('\n');
+    auto line = text.substr(0, end);
+    wire += stream;
+    wire += ' ';
+    wire += line;
+    wire += '\n';
+    if (end == std::string_view::npos)
+      break;
+    text.remove_prefix(end + 1);
+  }
+}
+} // namespace Protocol
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef SECTOR_HPP
+#define SECTOR_HPP
+
+#include "BufferManager.hpp"
+#include "Transaction.hpp"
+#include "Type.hpp"
+#include <shared_mutex>
+#include <type_traits>
+#include <utility>
+
+extern BufferManager buffer_manager;
+
+// Cantidad de registros de un tamaño que entran en un sector de datos,
+// según la geometría del disco abierto. Cada uno ocupa además su versión
+// y un bit del mapa, que se rellena hasta alinear las versiones
+inline int records_per_sector(std::size_t record_size) {
+  return 8 *
+         (global.bytes - sizeof(Address) - sizeof(int) - alignof(Version)) /
+         (8 * (record_size + sizeof(Version)) + 1);
+}
+
+// Bytes del mapa de ocupación al inicio de cada sector de datos
+inline int bitmap_size(std::size_t record_size) {
+  return (records_per_sector(record_size) + 7) / 8;
+}
+
+// Distancia entre las entradas de un sector temporal: cada una empieza
+// alineada como una dirección, así sus claves y campos de 8 bytes
+// también quedan alineados
+inline std::size_t spill_stride(std::size_t entry_size) {
+  constexpr auto align = alignof(Address);
+  return (entry_size + align - 1) / align * align;
+}
+
+// Cantidad de entradas de un tamaño que entran en un sector temporal,
+// después del siguiente sector, el contador y el relleno hasta alinear
+inline int spill_entries_per_sector(std::size_t entry_size) {
+  return (global.bytes - sizeof(Address) - sizeof(int) - alignof(Address)) /
+         spill_stride(entry_size);
+}
+
+// Latch de un sector (los sectores se reparten entre unos pocos). Lo
+// toman compartido las lecturas mientras examinan el mapa, las versiones
+// y el siguiente sector, y en exclusiva las escrituras que los cambian.
+// Nunca se toma más de uno a la vez
+std::shared_mutex& sector_latch(Address address);
+
+// Entrada del directorio de tablas guardado en el sector 0
+struct Table {
+  Db::SmallString name;
+  Address sector;
+};
+
+// Manejador de un sector del disco, mantiene su bloque fijado en el
+// buffer mientras exista. El puntero al sector se resuelve una sola vez
+// al fijarlo, los accesos posteriores no vuelven a pasar por el buffer
+template <bool Readonly = true>
+struct SectorHandle {
+  using Data = std::conditional_t<Readonly, const char*, char*>;
+  Address address;
+  Data data = nullptr;
+
+  explicit SectorHandle(Address a = NullAddress) : address(a) {
+    if (address == NullAddress)
+      return;
+    data = buffer_manager.pin_sector<Readonly>(address);
+  }
+
+  SectorHandle(const SectorHandle&) = delete;
+  SectorHandle(SectorHandle&& other) :
+      address(std::exchange(other.address, NullAddress)),
+      data(std::exchange(other.data, nullptr)) {}
+  SectorHandle& operator=(SectorHandle&& other) {
+    if (this != &other) {
+      this->~SectorHandle();
+      new (this) SectorHandle(std::move(other));
+    }
+    return *this;
+  }
+
+  SectorHandle(SectorHandle<false>&& other)
+  requires Readonly
+      : address(std::exchange(other.address, NullAddress)),
+        data(std::exchange(other.data, nullptr)) {}
+
+  ~SectorHandle() {
+    if (address != NullAddress)
+      buffer_manager.unpin(address);
+  }
+
+  auto as_tables() {
+    return reinterpret_cast<std::conditional_t<Readonly, const Table*, Table*>>(
+        data);
+  }
+
+  Address get() {
+    return address;
+  }
+
+  auto&& next_sector() {
+    return *reinterpret_cast<
+        std::conditional_t<Readonly, const Address*, Address*>>(data);
+  }
+
+  auto&& column_size() {
+    return *reinterpret_cast<std::conditional_t<Readonly, const int*, int*>>(
+        data + sizeof(Address));
+  }
+
+  auto&& record_count() {
+    return *reinterpret_cast<std::conditional_t<Readonly, const int*, int*>>(
+        data + sizeof(Address));
+  }
+
+  // Campo de tipo T en el primer desplazamiento alineado desde offset.
+  // Los sectores empiezan alineados a 8 bytes
+  template <class T>
+  auto field_at(std::size_t offset) {
+    constexpr auto align = alignof(T);
+    return reinterpret_cast<std::conditional_t<Readonly, const T*, T*>>(
+        data + (offset + align - 1) / align * align);
+  }
+
+  std::size_t offset_of(const void* field) {
+    return static_cast<const char*>(field) - data;
+  }
+
+  auto columns() {
+    return field_at<Db::Column>(sizeof(Address) + sizeof(int));
+  }
+
+  // En la cabecera de una tabla, después de las columnas, se guarda el
+  // último sector de la cadena y el directorio de sectores con espacio
+  auto&& last_sector() {
+    return *field_at<Address>(offset_of(columns() + column_size()));
+  }
+
+  auto&& free_count() {
+    return *field_at<int>(offset_of(&last_sector() + 1));
+  }
+
+  auto free_sectors() {
+    return field_at<Address>(offset_of(&free_count() + 1));
+  }
+
+  int free_capacity() {
+    auto used = reinterpret_cast<const char*>(free_sectors()) - data;
+    return (global.bytes - used) / sizeof(Address);
+  }
+
+  auto bitmap() {
+    return data + sizeof(Address) + sizeof(int);
+  }
+
+  // Las versiones de los espacios van entre el mapa y los registros
+  auto versions(int bitmap_size) {
+    return field_at<Version>(offset_of(bitmap() + bitmap_size));
+  }
+
+  auto record_data(int bitmap_size, int record_idx, int record_size) {
+    auto records = reinterpret_cast<Data>(versions(bitmap_size) +
+                                          records_per_sector(record_size));
+    return records + record_idx * record_size;
+  }
+
+  // Los sectores temporales no tienen mapa ni versiones, las entradas
+  // empiezan alineadas después del contador
+  auto spill_entry(int entry_idx, std::size_t entry_size) {
+    auto first = field_at<Address>(sizeof(Address) + sizeof(int));
+    auto entries = reinterpret_cast<Data>(first);
+    return entries + entry_idx * spill_stride(entry_size);
+  }
+
+  std::shared_mutex& latch() {
+    return sector_latch(address);
+  }
+};
+
+// Busca un sector libre (siguiente sector en 0) a partir
+// del último sector entregado, recorriendo el disco en círculo
+Address allocate_sector();
+
+template <bool Readonly = true>
+auto new_handle() {
+  return SectorHandle<Readonly>{allocate_sector()};
+}
+
+// Devuelve un sector al disco marcándolo como libre
+void free_sector(Address sector_address);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "BufferManager.hpp"
+#include "Command.hpp"
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Servidor local: escucha en un socket Unix y atiende muchas sesiones
+// con un solo buffer y un solo catálogo. Un hilo con epoll acepta las
+// conexiones, lee las líneas y escribe las respuestas; las sentencias
+// se ejecutan en un grupo de hilos. Cada sesión tiene como mucho una
+// sentencia en curso, así sus respuestas salen en orden
+class Server {
+  struct Client {
+    int fd = -1;
+    Session session;
+    std::string input;
+    std::string output;
+    // Hay una sentencia suya en un hilo del grupo
+    bool busy = false;
+    // El cliente ya no envía más, se cierra al terminar de responder
+    bool hangup = false;
+    // Está registrado en epoll
+    bool watched = false;
+  };
+
+  struct Job {
+    int client;
+    // El hilo del bucle no la toca mientras el cliente está ocupado
+    Session* session;
+    std::string line;
+  };
+
+  struct Done {
+    int client;
+    std::string response;
+  };
+
+  std::filesystem::path socket_path;
+  int listener = -1;
+  int epoll = -1;
+  // Lo escriben los hilos del grupo para despertar al bucle de eventos
+  int wakeup = -1;
+  // Señales de fin, se atienden en el bucle de eventos
+  int signals = -1;
+  std::map<int, Client> clients;
+
+  std::mutex jobs_mutex;
+  std::condition_variable_any jobs_ready;
+  std::deque<Job> jobs;
+  std::mutex done_mutex;
+  std::vector<Done> done;
+  std::vector<std::jthread> workers;
+
+  void accept_clients();
+  void read_client(Client& client);
+  void write_client(Client& client);
+  void dispatch(Client& client);
+  // Ajusta los eventos de epoll a lo que el cliente espera
+  void watch(Client& client);
+  void finish_jobs();
+  // Cierra el cliente si ya no le queda nada por hacer
+  void release(int fd);
+  void work(std::stop_token stop);
+
+public:
+  // Cada lectura fija hasta dos bloques y la escritura en curso, que es
+  // una sola, hasta cuatro: no se admiten más hilos de los que entran en
+  // el buffer
+  static constexpr int max_workers = (BufferManager::capacity - 1) / 2;
+
+  Server(std::filesystem::path path, int worker_count);
+  Server(const Server&) = delete;
+  ~Server();
+
+  // Atiende hasta recibir SIGINT o SIGTERM
+  void run();
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef SETTINGS_HPP
+#define SETTINGS_HPP
+
+#include <cstddef>
+
+// Parámetros del motor que se pueden cambiar con SET
+struct Settings {
+  // Bytes de memoria que puede usar un operador (ordenamiento)
+  // antes de volcar datos a sectores temporales
+  std::size_t work_memory = 1 << 20;
+  // Después de un DELETE se compacta la tabla si la fracción de
+  // espacio ocupado por registros vivos queda por debajo (0 = nunca)
+  double autovacuum_fill_factor = 0;
+  // Leer y escribir los sectores con O_DIRECT, sin pasar por el caché
+  // de páginas del sistema (si el sistema de archivos lo admite)
+  bool direct_io = false;
+  // Transferir los sectores de cada bloque en paralelo, con un hilo
+  // por plato, en vez de uno tras otro desde el hilo que los pide. Solo
+  // conviene si los platos están en dispositivos distintos: en uno solo
+  // el traspaso entre hilos cuesta más de lo que se gana
+  bool parallel_io = false;
+  // Guardar comprimidos los bloques que se escriben desde el buffer.
+  // Los bloques ya escritos se leen bien con cualquier valor
+  bool compression = false;
+};
+
+inline Settings settings;
+
+#endif
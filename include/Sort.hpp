@@ -0,0 +1,68 @@
+#ifndef SORT_HPP
+#define SORT_HPP
+
+#include "Spill.hpp"
+#include <span>
+#include <vector>
+
+// Escribe el campo como una clave cuyo orden coincide con el de memcmp,
+// ocupa size_of_type(type) bytes
+void normalize_key(const char* field, Db::Type type, bool descending,
+                   char* key);
+
+// Ordenamiento externo por clave normalizada, mantiene en memoria
+// hasta memory_budget bytes y vuelca el resto en corridas temporales
+// que luego se combinan a través del buffer
+class ExternalSorter {
+  struct Cursor {
+    SpillReader reader;
+    const char* entry;
+  };
+
+  std::size_t key_size;
+  std::size_t entry_size;
+  std::size_t memory_budget;
+  std::vector<char> buffer;
+  std::vector<const char*> sorted;
+  std::size_t sorted_idx = 0;
+  std::vector<Address> runs;
+  std::vector<Cursor> cursors;
+  std::vector<std::size_t> heap;
+  std::size_t advance = 0;
+
+  void sort_buffer();
+  void spill_buffer();
+  void open_cursors(std::span<const Address> inputs);
+  const char* next_entry();
+  Address merge_runs(std::span<const Address> inputs);
+
+public:
+  ExternalSorter(std::size_t key_size, std::size_t record_size,
+                 std::size_t memory_budget);
+  ~ExternalSorter();
+  void add(const char* key, const char* record);
+  // Termina la fase de carga, a partir de aquí solo se puede leer
+  void finish();
+  // Siguiente registro en orden o nullptr al terminar, el puntero
+  // es válido hasta la siguiente llamada
+  const char* next();
+};
+
+// Conserva solo los limit registros con menor clave, para ORDER BY
+// con LIMIT sin ordenar toda la entrada
+class TopNHeap {
+  std::size_t key_size;
+  std::size_t entry_size;
+  std::size_t limit;
+  std::vector<char> entries;
+  std::vector<std::size_t> heap;
+  std::size_t heap_idx = 0;
+
+public:
+  TopNHeap(std::size_t key_size, std::size_t record_size, std::size_t limit);
+  void add(const char* key, const char* record);
+  void finish();
+  const char* next();
+};
+
+#endif
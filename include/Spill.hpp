@@ -0,0 +1,41 @@
+#ifndef SPILL_HPP
+#define SPILL_HPP
+
+#include "Sector.hpp"
+
+// Secuencia de entradas de tamaño fijo escrita en sectores temporales
+// del disco, usada cuando una operación no cabe en memoria
+class SpillWriter {
+  std::size_t entry_size;
+  int entries_per_sector;
+  Address first_address = NullAddress;
+  SectorHandle<false> sector;
+
+public:
+  explicit SpillWriter(std::size_t entry_size);
+  void write(const char* entry);
+  // Termina la escritura y devuelve el primer sector de la secuencia
+  Address finish();
+};
+
+// Lee secuencialmente las entradas escritas por un SpillWriter, cada
+// sector se libera en cuanto se termina de leer, así que una secuencia
+// solo se puede leer una vez
+class SpillReader {
+  std::size_t entry_size;
+  SectorHandle<> sector;
+  int entry_idx = 0;
+
+public:
+  SpillReader(Address first_address, std::size_t entry_size);
+  SpillReader(SpillReader&&) = default;
+  ~SpillReader();
+  // Devuelve la siguiente entrada o nullptr al terminar, el puntero
+  // es válido hasta la siguiente llamada
+  const char* next();
+};
+
+// Libera todos los sectores de una secuencia temporal
+void free_spill(Address first_address);
+
+#endif
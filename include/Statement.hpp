@@ -0,0 +1,89 @@
+#ifndef STATEMENT_HPP
+#define STATEMENT_HPP
+
+#include "Interpreter.hpp"
+#include "Table.hpp"
+#include <cstddef>
+#include <iosfwd>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// SELECT o DELETE ya analizado: las tablas, las cláusulas y el árbol
+// del WHERE, que se puede ejecutar muchas veces sin volver a leer el
+// texto. El árbol lee los marcadores $N de parameters
+struct Statement {
+  enum class Kind { Select, Join, Delete };
+
+  Kind kind = Kind::Select;
+  std::string table;
+  // Solo en los JOIN
+  std::string other_table;
+  std::string condition;
+  SelectOptions options;
+  // Columnas de cada tabla con las que se analizó el WHERE
+  std::vector<std::vector<Db::Column>> columns;
+  Db::Parameters parameters;
+  std::size_t parameter_count = 0;
+  // nullptr si no tiene WHERE
+  Db::NodePtr predicate;
+
+  bool read_only() const {
+    return kind != Kind::Delete;
+  }
+  // Se puede ejecutar junto con otras lecturas: no reserva sectores del
+  // disco (ORDER BY puede volcar corridas, EXPLAIN ANALYZE mide) y fija
+  // pocos bloques a la vez
+  bool concurrent() const {
+    return kind == Kind::Select && !options.order_by &&
+           options.explain != Explain::Analyze;
+  }
+  // Un DELETE solo marca versiones, las lecturas en curso no lo ven y no
+  // lo esperan. Igual ocupa el lugar de la única escritura en curso
+  bool versioned_write() const {
+    return kind == Kind::Delete && options.explain != Explain::Analyze;
+  }
+};
+
+// Analiza un SELECT o un DELETE, con el prefijo EXPLAIN [ANALYZE]
+// opcional. Devuelve nullptr si el texto no es uno, o si alguna tabla
+// no existe (después de avisarlo)
+std::unique_ptr<Statement> parse_statement(std::string_view text);
+
+// Asigna los valores de EXECUTE nombre(valor, ...), separados por comas.
+// Devuelve false si no coinciden con los marcadores de la sentencia
+bool bind_parameters(Statement& statement, std::string_view values);
+
+void execute(const Statement& statement, std::ostream& out);
+
+// Texto con los espacios repetidos colapsados fuera de las comillas,
+// la clave del caché de planes
+std::string normalize_statement(std::string_view text);
+
+// Caché de sentencias analizadas por texto normalizado, descarta la
+// menos usada recientemente al llenarse. Las sentencias se comparten:
+// una que se está ejecutando sigue viva aunque salga del caché
+class PlanCache {
+  using Entry = std::pair<std::string, std::shared_ptr<const Statement>>;
+
+  std::size_t capacity;
+  // La más reciente primero
+  std::list<Entry> entries;
+  // Las claves apuntan al texto de cada entrada de la lista
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+
+public:
+  explicit PlanCache(std::size_t _capacity = 64) : capacity{_capacity} {}
+
+  // Sentencia guardada con esa clave, o nullptr
+  std::shared_ptr<const Statement> find(std::string_view key);
+  void insert(std::string key, std::shared_ptr<const Statement> statement);
+  std::size_t size() const {
+    return entries.size();
+  }
+};
+
+#endif
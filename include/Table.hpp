@@ -1,12 +1,72 @@
 #ifndef CSV_HPP
 #define CSV_HPP
 
+#include "Explain.hpp"
+#include "Type.hpp"
+#include <iostream>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <vector>
 
-void load_csv(std::string_view csv);
-void select_all(std::string_view table);
-void select_all_where(std::string_view table, std::string_view expr);
-void delete_where(std::string_view table, std::string_view expr);
-void disk_info();
+namespace Db {
+struct Node;
+}
+
+struct OrderBy {
+  std::string column;
+  bool descending = false;
+};
+
+// Columnas pedidas y cláusulas opcionales al final de un SELECT
+struct SelectOptions {
+  // Vacío para SELECT *
+  std::vector<std::string> columns;
+  std::optional<OrderBy> order_by;
+  std::optional<std::size_t> limit;
+  Explain explain = Explain::None;
+};
+
+// Carga csv.csv como una tabla nueva, o si append es verdadero
+// agrega sus filas a la tabla ya existente. Devuelve falso si se pidió
+// agregar a una tabla que no existe
+bool load_csv(std::string_view csv, bool append = false);
+// INSERT INTO table VALUES (...), (...), devuelve las filas insertadas
+// o nullopt si la sentencia es inválida, después de informar el error
+std::optional<int> insert_values(std::string_view table,
+                                 std::string_view values);
+// Columnas de la tabla, o nullopt si no existe
+std::optional<std::vector<Db::Column>> table_columns(std::string_view table);
+
+// Las consultas escriben sus registros (o su plan) en out. Las que
+// reciben el WHERE como texto lo analizan con las columnas de la tabla,
+// las que reciben un árbol ya analizado (sentencias preparadas) lo
+// usan tal cual, sin WHERE si predicate es nullptr
+void select_all(std::string_view table, const SelectOptions& options = {},
+                std::ostream& out = std::cout);
+void select_all_where(std::string_view table, std::string_view expr,
+                      const SelectOptions& options = {},
+                      std::ostream& out = std::cout);
+void select_where(std::string_view table, const Db::Node* predicate,
+                  const SelectOptions& options = {},
+                  std::ostream& out = std::cout);
+// SELECT * FROM left JOIN right ON condition [WHERE expr]
+void select_join(std::string_view left, std::string_view right,
+                 std::string_view condition, std::string_view expr,
+                 const SelectOptions& options = {},
+                 std::ostream& out = std::cout);
+void select_join(std::string_view left, std::string_view right,
+                 std::string_view condition, const Db::Node* predicate,
+                 const SelectOptions& options = {},
+                 std::ostream& out = std::cout);
+void delete_where(std::string_view table, std::string_view expr,
+                  Explain explain = Explain::None,
+                  std::ostream& out = std::cout);
+void delete_where(std::string_view table, const Db::Node& predicate,
+                  Explain explain = Explain::None,
+                  std::ostream& out = std::cout);
+// Compacta la tabla y devuelve cuántos sectores se liberaron
+int vacuum(std::string_view table);
+void disk_info(std::ostream& out = std::cout);
 
 #endif
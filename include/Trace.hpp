@@ -0,0 +1,80 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class TraceEvent : std::uint8_t {
+  Pin,
+  Unpin,
+  Hit,
+  Miss,
+  Evict,
+  Flush,
+  SectorRead,
+  SectorWrite,
+  QueryBegin,
+  QueryEnd,
+};
+
+struct TraceBuffer;
+
+// Trazador de eventos que se activa en tiempo de ejecución (TRACE ON).
+// Cada hilo escribe en su propio buffer circular sin bloqueos, y TRACE
+// DUMP los recorre y los exporta en el formato JSON de Chrome/Perfetto.
+// Desactivado, registrar un evento cuesta una lectura atómica
+class Tracer {
+  std::atomic<bool> enabled = false;
+  std::atomic<std::int64_t> started = 0;
+
+  mutable std::mutex registry_mutex;
+  std::vector<std::shared_ptr<TraceBuffer>> buffers;
+  std::vector<std::string> queries;
+
+  void append(TraceEvent event, std::int64_t argument);
+  TraceBuffer& local_buffer();
+
+public:
+  void record(TraceEvent event, std::int64_t argument = 0) {
+    if (enabled.load(std::memory_order_relaxed)) [[unlikely]]
+      append(event, argument);
+  }
+  bool active() const {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  // Solo se exportan los eventos desde el último start
+  void start();
+  void stop();
+  void dump(std::ostream& os) const;
+
+  // Marca el inicio y fin de una sentencia, guardando su texto
+  void begin_query(std::string_view query);
+  void end_query();
+};
+
+inline Tracer tracer;
+
+// Registra el inicio de una sentencia y su fin al salir del ámbito
+class QueryTrace {
+  bool traced;
+
+public:
+  explicit QueryTrace(std::string_view query) : traced{tracer.active()} {
+    if (traced)
+      tracer.begin_query(query);
+  }
+  QueryTrace(const QueryTrace&) = delete;
+  ~QueryTrace() {
+    if (traced)
+      tracer.end_query();
+  }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef TRANSACTION_HPP
+#define TRANSACTION_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+
+// Identificador de la transacción que escribió una versión. Se asignan
+// en orden creciente y se guardan en disk/xid para seguir después de
+// reiniciar. El 0 es una versión congelada, visible para todas
+using Xid = std::uint32_t;
+
+// Versión de un espacio de un sector: la transacción que creó el
+// registro y la que lo borró, 0 si sigue vivo
+struct Version {
+  Xid xmin;
+  Xid xmax;
+};
+
+// Lo que ve una sentencia: las transacciones confirmadas antes de que
+// empezara y la suya propia
+struct Snapshot {
+  // Primer identificador sin confirmar al tomarla
+  Xid horizon = 0;
+  // Escritura en curso al tomarla, 0 si no había
+  Xid active = 0;
+  // La propia si escribe, 0 si solo lee
+  Xid own = 0;
+
+  bool sees(Xid xid) const {
+    return xid == 0 || xid == own || (xid < horizon && xid != active);
+  }
+  bool visible(const Version& version) const {
+    return sees(version.xmin) && !(version.xmax && sees(version.xmax));
+  }
+};
+
+// Las escrituras se ejecutan de a una y las lecturas sin esperarlas: una
+// escritura no cambia los registros que ven las lecturas en curso, solo
+// crea versiones nuevas (o marca las viejas como borradas) que ellas no
+// ven. Una sola escritura a la vez alcanza para que toda transacción
+// menor que la que está escribiendo ya esté confirmada
+class TransactionManager {
+  std::mutex mutex;
+  // 0 mientras no se leyó disk/xid
+  Xid next = 0;
+  Xid writing = 0;
+  // Transacción más antigua que cada lectura en curso podría no ver
+  std::multiset<Xid> readers;
+
+  std::mutex writer;
+  // Compartido por las lecturas mientras duran, en exclusiva para
+  // compactar, que cambia los registros de lugar
+  std::shared_mutex relocation;
+
+  void load();
+  friend class ReadTransaction;
+
+public:
+  Snapshot begin_read();
+  void end_read(const Snapshot& snapshot);
+  Snapshot begin_write();
+  void commit(const Snapshot& snapshot);
+
+  // Los registros borrados por transacciones menores ya no los ve nadie
+  Xid oldest();
+
+  // Permiso para compactar, que cambia registros de lugar: exige que no
+  // haya lecturas en curso. Solo se pide desde una escritura que todavía
+  // no escribió nada. Sin wait no espera a las lecturas y puede volver
+  // sin el permiso
+  std::unique_lock<std::shared_mutex> relocation_lock(bool wait);
+};
+
+inline TransactionManager transactions;
+
+// Transacción de una sentencia que solo lee, hasta salir del ámbito
+class ReadTransaction {
+  std::shared_lock<std::shared_mutex> relocation;
+
+public:
+  const Snapshot snapshot;
+
+  ReadTransaction() :
+      relocation{transactions.relocation},
+      snapshot{transactions.begin_read()} {}
+  ReadTransaction(const ReadTransaction&) = delete;
+  ~ReadTransaction() {
+    transactions.end_read(snapshot);
+  }
+};
+
+// Transacción de una sentencia que escribe. Se confirma al salir del
+// ámbito, también si se sale por una excepción: como antes de las
+// versiones, lo que alcanzó a escribir queda escrito
+class WriteTransaction {
+public:
+  const Snapshot snapshot{transactions.begin_write()};
+
+  WriteTransaction() = default;
+  WriteTransaction(const WriteTransaction&) = delete;
+  ~WriteTransaction() {
+    transactions.commit(snapshot);
+  }
+};
+
+#endif
@@ -1,9 +1,20 @@
+#include "Batch.hpp"
 #include "Disk.hpp"
-#include "Table.hpp"
+#include "Errors.hpp"
+#include "Metrics.hpp"
+#include "Protocol.hpp"
+#include "Sector.hpp"
+#include "Server.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-void handle_inputs() {
+void print_disk() {
   std::clog << "Información del disco:\n";
   std::clog << "Número de platos: " << global.plates << '\n';
   std::clog << "Número de pistas por plato: " << global.tracks << '\n';
@@ -11,64 +22,112 @@ void handle_inputs() {
   std::clog << "Número de bytes por sector: " << global.bytes << '\n';
   std::clog << "Número de sectores por bloque: " << global.block_size << '\n'
             << '\n';
+}
 
+void handle_inputs(Session& session) {
+  print_disk();
   std::string line;
   while (std::clog << "  > ", std::getline(std::cin, line)) {
-    std::stringstream ss{std::move(line)};
-    std::string word;
-    ss >> word;
-    if (word == "LOAD") {
-      std::string name;
-      ss >> name;
-      load_csv(name);
-      std::clog << "\tSe cargó la tabla " << name << " exitosamente\n";
-    } else if (word == "SELECT") {
-      std::string fields;
-      ss >> fields;
-      if (fields == "*") {
-        std::string FROM;
-        ss >> FROM;
-        if (FROM == "FROM") {
-          std::string table_name;
-          ss >> table_name;
+    QueryTrace trace(line);
+    LatencyTimer timer(metrics.query_latency);
+    try {
+      run_command(line, session, std::cout);
+    } catch (const std::exception& e) {
+      errors() << "Error: " << e.what() << '\n';
+    }
+  }
+  std::clog << std::endl;
+}
 
-          std::string WHERE;
-          ss >> WHERE;
-          if (WHERE == "WHERE") {
-            std::string clause;
-            std::getline(ss, clause, '\n');
-            select_all_where(table_name, clause);
-          } else {
-            select_all(table_name);
-          }
-        }
-      }
-    } else if (word == "DELETE") {
-      std::string FROM;
-      ss >> FROM;
-      if (FROM == "FROM") {
-        std::string table_name;
-        ss >> table_name;
+void usage() {
+  std::cerr << "Uso: disco [--plates N] [--tracks N] [--sectors N]"
+               " [--bytes N] [--block-size N]\n"
+               "            [--script archivo | --batch] [--continue-on-error]"
+               " [--timings] [--jobs N]\n"
+               "            [--serve [--socket ruta]]\n";
+}
 
-        std::string WHERE;
-        ss >> WHERE;
-        if (WHERE == "WHERE") {
-          std::string clause;
-          std::getline(ss, clause, '\n');
-          delete_where(table_name, clause);
-        }
-      }
-    } else if (word == "INFO")
-      disk_info();
+// Valor entero de una opción de la línea de comandos
+int parse_number(std::string_view option, const std::string& value) {
+  try {
+    std::size_t used;
+    int number = std::stoi(value, &used);
+    if (used == value.size())
+      return number;
+  } catch (const std::logic_error&) {
   }
-  std::clog << std::endl;
+  throw std::invalid_argument("Valor inválido para " + std::string(option) +
+                              ": " + value);
 }
 
-int main() {
-  if (!fs::exists(disk_path)) {
-    DiskInfo diskInfo;
-    std::cout << "El disco aún no existe, se procederá a su creación\n\n";
-    make_disk();
+int main(int argc, char** argv) {
+  // La geometría solo se usa al crear el disco, después se lee del superbloque
+  DiskInfo diskInfo;
+  BatchOptions batch;
+  std::optional<std::string> script;
+  bool serve = false;
+  fs::path socket_path{Protocol::default_socket};
+  std::vector<std::string> args(argv + 1, argv + argc);
+  try {
+    for (auto idx = 0uz; idx < args.size(); idx++) {
+      const auto& arg = args[idx];
+      bool has_value = idx + 1 < args.size();
+      if (arg == "--script" && has_value)
+        script = args[++idx];
+      else if (arg == "--batch")
+        script.emplace(1, '-');
+      else if (arg == "--serve")
+        serve = true;
+      else if (arg == "--socket" && has_value)
+        socket_path = args[++idx];
+      else if (arg == "--continue-on-error")
+        batch.continue_on_error = true;
+      else if (arg == "--timings")
+        batch.timings = true;
+      else if (arg == "--jobs" && has_value)
+        batch.jobs = std::clamp(parse_number(arg, args[++idx]), 1,
+                                (BufferManager::capacity - 1) / 2);
+      else if (auto field = geometry_option(diskInfo, arg); field && has_value)
+        *field = parse_number(arg, args[++idx]);
+      else {
+        usage();
+        return 1;
+      }
+    }
+
+    if (!fs::exists(disk_path)) {
+      if (!script && !serve)
+        std::cout << "El disco aún no existe, se procederá a su creación\n\n";
+      make_disk(diskInfo);
+    } else {
+      open_disk();
+      buffer_manager.start_warm_up();
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+
+  if (serve) {
+    // Todas las sesiones comparten el buffer y el catálogo de este proceso
+    Server server(socket_path, batch.jobs);
+    std::clog << "Escuchando en " << socket_path.string() << '\n';
+    server.run();
+    return 0;
+  }
+
+  Session session;
+  if (!script) {
+    handle_inputs(session);
+    return 0;
+  }
+  // Sin prompt ni datos del disco, el código de salida indica si hubo errores
+  if (*script == "-")
+    return run_batch(std::cin, session, batch) ? 1 : 0;
+  std::ifstream file(*script);
+  if (!file) {
+    std::cerr << "No se pudo abrir " << *script << '\n';
+    return 1;
   }
-  handle_inputs();
+  return run_batch(file, session, batch) ? 1 : 0;
 }
@@ -0,0 +1,131 @@
+#include "Batch.hpp"
+#include "Errors.hpp"
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+class Runner {
+  const BatchOptions& options;
+  std::deque<std::future<CommandResult>> pending;
+  int statements = 0;
+  int failures = 0;
+  double total_seconds = 0;
+
+  // Muestra el resultado, devuelve falso si hay que detenerse
+  bool report(const CommandResult& result) {
+    statements++;
+    total_seconds += result.seconds;
+    std::cout << result.output << std::flush;
+    std::clog << result.notices;
+    errors() << result.errors << std::flush;
+    if (options.timings)
+      std::clog << "\t[" << statements << "] " << std::fixed
+                << std::setprecision(3) << result.seconds * 1e3
+                << std::defaultfloat << " ms " << result.line << '\n';
+    if (result.failed)
+      failures++;
+    return !result.failed || options.continue_on_error;
+  }
+
+public:
+  bool stopped = false;
+
+  explicit Runner(const BatchOptions& _options) : options{_options} {}
+
+  // Espera a las sentencias en curso hasta dejar como mucho keep
+  void drain(std::size_t keep = 0) {
+    while (pending.size() > keep) {
+      auto result = pending.front().get();
+      pending.pop_front();
+      if (!stopped && !report(result))
+        stopped = true;
+    }
+  }
+
+  void run_concurrent(std::string line,
+                      std::shared_ptr<const Statement> statement) {
+    drain(std::max(options.jobs, 1) - 1);
+    if (stopped)
+      return;
+    pending.push_back(std::async(
+        std::launch::async, [line = std::move(line), statement] {
+          return capture_command(line, [&](std::ostream& out) {
+            execute(*statement, out);
+          });
+        }));
+  }
+
+  template <class Run>
+  void run_exclusive(std::string line, Run&& run) {
+    drain();
+    if (stopped)
+      return;
+    if (!report(capture_command(std::move(line), run)))
+      stopped = true;
+  }
+
+  int finish() {
+    drain();
+    if (options.timings)
+      std::clog << "\t" << statements << " sentencias en " << std::fixed
+                << std::setprecision(3) << total_seconds * 1e3
+                << std::defaultfloat << " ms, " << failures
+                << " con errores\n";
+    return failures;
+  }
+};
+
+bool skipped(std::string_view line) {
+  auto start = line.find_first_not_of(" \t\r");
+  return start == std::string_view::npos ||
+         line.substr(start).starts_with("--");
+}
+} // namespace
+
+int run_batch(std::istream& input, Session& session,
+              const BatchOptions& options) {
+  Runner runner(options);
+  std::string line;
+  while (!runner.stopped && std::getline(input, line)) {
+    if (skipped(line))
+      continue;
+    // El análisis ocurre en este hilo, en orden, para que el caché de
+    // planes y las sentencias preparadas no se compartan entre hilos
+    std::shared_ptr<const Statement> statement;
+    std::stringstream ss{line};
+    std::string word;
+    ss >> word;
+    if (options.jobs > 1 && word == "SELECT") {
+      std::ostringstream parse_errors;
+      try {
+        StreamCapture redirect(error_output, parse_errors);
+        statement = cached_statement(session, line);
+      } catch (const std::exception& e) {
+        parse_errors << "Error: " << e.what() << '\n';
+      }
+      if (!statement) {
+        runner.run_exclusive(line, [&](std::ostream&) {
+          errors() << std::move(parse_errors).str();
+        });
+        continue;
+      }
+    }
+    if (statement && statement->concurrent())
+      runner.run_concurrent(line, std::move(statement));
+    else if (statement)
+      runner.run_exclusive(line, [&](std::ostream& out) {
+        execute(*statement, out);
+      });
+    else
+      runner.run_exclusive(line, [&](std::ostream& out) {
+        run_command(line, session, out);
+      });
+  }
+  return runner.finish();
+}
@@ -1,141 +1,292 @@
 #include "BufferManager.hpp"
+#include "Metrics.hpp"
+#include "Settings.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <print>
 
-static constexpr bool log_info = false;
+namespace {
+struct WarmEntry {
+  std::int64_t block_id;
+  std::int64_t accesses;
+};
 
-Frame::Frame(int frame_id) {
-  std::ostringstream oss;
-  for (int sector = 0; sector < global.block_size; sector++) {
-    Address sector_address = {frame_id * global.block_size + sector};
-    std::ifstream sector_file = sector_address.to_path();
-    oss << sector_file.rdbuf();
+fs::path warm_path() {
+  return disk_path / "warm";
+}
+} // namespace
+
+void BufferManager::transfer_block(std::int64_t block_id, char* data,
+                                   int sectors, bool write) {
+  if (!scheduler || !settings.parallel_io) {
+    for (int sector = 0; sector < sectors; sector++)
+      transfer_sector({block_id * global.block_size + sector},
+                      data + sector * global.bytes, write);
+    return;
   }
 
-  content = std::move(oss).str();
+  IoBatch batch;
+  for (int sector = 0; sector < sectors; sector++)
+    scheduler->submit({{block_id * global.block_size + sector},
+                       data + sector * global.bytes,
+                       write,
+                       &batch});
+  batch.wait();
 }
 
-template <bool Readonly>
-auto Frame::data(this std::conditional_t<Readonly, const Frame&, Frame&> self) {
-  if constexpr (!Readonly)
-    self.dirty_bit = true;
-  return self.content.data();
+std::int64_t BufferManager::load_frame(int frame) {
+  auto block_id = frames[frame].block_id;
+  auto block_bytes = static_cast<std::size_t>(global.block_size) * global.bytes;
+  int sectors = extents->stored_sectors(block_id);
+  if (sectors == global.block_size)
+    transfer_block(block_id, frame_data(frame), sectors, false);
+  else {
+    transfer_block(block_id, staging(), sectors, false);
+    auto stored_bytes = static_cast<std::size_t>(sectors) * global.bytes;
+    decompress_block({staging(), stored_bytes},
+                     {frame_data(frame), block_bytes});
+  }
+  return std::int64_t{sectors} * global.bytes;
 }
 
-template auto Frame::data<true>(this const Frame& self);
-template auto Frame::data<false>(this Frame& self);
+void BufferManager::read_frame(int frame) {
+  LatencyTimer timer(metrics.miss_latency);
+  counters.bytes_read += load_frame(frame);
+}
+
+void BufferManager::write_frame(int frame) {
+  auto block_id = frames[frame].block_id;
+  tracer.record(TraceEvent::Flush, block_id);
+  metrics.buffer_writebacks.add();
+
+  // Solo se guarda comprimido si ahorra al menos un sector
+  auto block_bytes = static_cast<std::size_t>(global.block_size) * global.bytes;
+  char* source = frame_data(frame);
+  int sectors = global.block_size;
+  if (settings.compression)
+    if (auto packed = compress_block({source, block_bytes},
+                                     {staging(), block_bytes - global.bytes})) {
+      sectors = (packed + global.bytes - 1) / global.bytes;
+      std::memset(staging() + packed, 0, sectors * global.bytes - packed);
+      source = staging();
+    }
+  transfer_block(block_id, source, sectors, true);
+  extents->set(block_id, sectors);
+  frames[frame].dirty_bit = false;
+  counters.bytes_written += std::int64_t{sectors} * global.bytes;
+}
 
 BufferManager::~BufferManager() {
-  for (auto& [frame_id, frame] : pool) {
-    if (frame.dirty_bit) {
-      for (int sector = 0; sector < global.block_size; sector++) {
-        auto sector_data = frame.data() + sector * global.bytes;
-        Address sector_address = {frame_id * global.block_size + sector};
-        std::ofstream sector_file = sector_address.to_path();
-        sector_file.write(sector_data, global.bytes);
-      }
+  finish_warm_up();
+  for (int frame = 0; frame < capacity; frame++)
+    if (frames[frame].block_id >= 0 && frames[frame].dirty_bit)
+      write_frame(frame);
+
+  // Del más reciente al más antiguo. Si el disco ya no existe (se borró
+  // antes de salir) el archivo simplemente no se crea
+  std::vector<WarmEntry> entries;
+  for (int frame = mru_head; frame >= 0; frame = frames[frame].older)
+    entries.push_back({frames[frame].block_id, frames[frame].accesses});
+  if (entries.empty())
+    return;
+  std::ofstream file(warm_path(), std::ios::binary);
+  file.write(reinterpret_cast<const char*>(entries.data()),
+             entries.size() * sizeof(WarmEntry));
+}
+
+void BufferManager::start_warm_up() {
+  std::ifstream file(warm_path(), std::ios::binary);
+  std::vector<WarmEntry> entries;
+  for (WarmEntry entry;
+       file.read(reinterpret_cast<char*>(&entry), sizeof(entry));)
+    entries.push_back(entry);
+
+  auto total_blocks = global.total_sectors() / global.block_size;
+  std::erase_if(entries, [&](const WarmEntry& entry) {
+    return entry.block_id < 0 || entry.block_id >= total_blocks;
+  });
+  std::ranges::stable_sort(entries, std::ranges::greater{},
+                           &WarmEntry::accesses);
+  if (entries.size() > capacity)
+    entries.resize(capacity);
+  if (entries.empty())
+    return;
+
+  std::vector<std::int64_t> blocks;
+  for (const auto& entry : entries)
+    blocks.push_back(entry.block_id);
+  warmer = std::jthread([this, blocks = std::move(blocks)](
+                            std::stop_token stop) mutable {
+    warm_up(stop, std::move(blocks));
+  });
+}
+
+void BufferManager::warm_up(std::stop_token stop,
+                            std::vector<std::int64_t> blocks) {
+  allocate();
+  // Un error de lectura solo deja el buffer más frío, el mismo bloque
+  // se volverá a pedir (y a fallar) por el camino normal
+  try {
+    for (auto block_id : blocks) {
+      if (stop.stop_requested() || page_table.find(block_id) >= 0)
+        continue;
+      int frame = resident;
+      frames[frame] = {block_id};
+      load_frame(frame);
+      page_table.insert(block_id, frame);
+      resident++;
+      // Se insertan de más a menos accedido, el más accedido queda al
+      // final de la lista MRU y es el último candidato a desalojo
+      push_front(frame);
     }
+  } catch (const std::exception&) {
+    frames[resident] = {};
   }
 }
 
-template <bool Readonly>
-std::conditional_t<Readonly, const char*, char*>
-BufferManager::load_sector(Address sector_address) {
-  total_access++;
-  int block_id = sector_address.address / global.block_size;
-  if (auto it = pool.find(block_id); it != pool.end()) {
-    hits++;
-    if constexpr (log_info)
-      std::println("Updating {}", block_id);
-    mru.erase(std::find(mru.begin(), mru.end(), block_id));
-    mru.push_front(block_id);
-    auto res = it->second.data<Readonly>() +
-               global.bytes * (sector_address.address % global.block_size);
-    if constexpr (log_info)
-      print();
-    return res;
-  }
+void BufferManager::unlink(int frame) {
+  auto& descriptor = frames[frame];
+  if (descriptor.newer >= 0)
+    frames[descriptor.newer].older = descriptor.older;
+  else
+    mru_head = descriptor.older;
+  if (descriptor.older >= 0)
+    frames[descriptor.older].newer = descriptor.newer;
+  descriptor.newer = descriptor.older = -1;
+}
 
-  if (pool.size() < capacity) {
-    if constexpr (log_info)
-      std::println("Adding {}", block_id);
-    mru.push_front(block_id);
-    auto [it, _] = pool.insert({block_id, Frame(block_id)});
-    auto res = it->second.data<Readonly>() +
-               global.bytes * (sector_address.address % global.block_size);
-    if constexpr (log_info)
-      print();
-    return res;
-  }
+void BufferManager::push_front(int frame) {
+  frames[frame].older = mru_head;
+  if (mru_head >= 0)
+    frames[mru_head].newer = frame;
+  mru_head = frame;
+}
 
-  auto mru_it = mru.begin();
-  while (mru_it != mru.end() && pool.at(*mru_it).pin_count != 0) {
-    if constexpr (log_info)
-      std::println("Ignoring {}", *mru_it);
-    mru_it++;
-  }
+void BufferManager::allocate() {
+  if (arena)
+    return;
+  auto bytes = static_cast<std::size_t>(capacity + 1) * global.block_size *
+               global.bytes;
+  arena.reset(new (std::align_val_t{frame_alignment}) char[bytes]);
+  extents = std::make_unique<ExtentMap>();
+  if (global.plates > 1)
+    scheduler = std::make_unique<IoScheduler>(global.plates);
+}
 
-  if (mru_it == mru.end())
-    throw std::runtime_error("Everything is pinned!");
-
-  int mru_id = *mru_it;
-  if constexpr (log_info)
-    std::println("Erasing {}", mru_id);
-  const Frame& mru_frame = pool.at(mru_id);
-  if (mru_frame.dirty_bit) {
-    for (int sector = 0; sector < global.block_size; sector++) {
-      auto sector_data = mru_frame.data() + sector * global.bytes;
-      Address sector_address = {mru_id * global.block_size + sector};
-      std::ofstream sector_file = sector_address.to_path();
-      sector_file.write(sector_data, global.bytes);
+int BufferManager::fetch(std::int64_t block_id) {
+  finish_warm_up();
+  counters.accesses++;
+  if (int frame = page_table.find(block_id); frame >= 0) {
+    counters.hits++;
+    frames[frame].accesses++;
+    tracer.record(TraceEvent::Hit, block_id);
+    if (frame != mru_head) {
+      unlink(frame);
+      push_front(frame);
     }
+    return frame;
   }
-  mru.erase(mru_it);
-  pool.erase(mru_id);
-
-  mru.push_front(block_id);
-  if constexpr (log_info)
-    std::println("Replacing {}", block_id);
-  auto [it, _] = pool.insert({block_id, Frame(block_id)});
-  auto res = it->second.data<Readonly>() +
-             global.bytes * (sector_address.address % global.block_size);
-  if constexpr (log_info)
-    print();
-  return res;
+
+  tracer.record(TraceEvent::Miss, block_id);
+  allocate();
+
+  int frame = 0;
+  if (resident < capacity) {
+    while (frames[frame].block_id >= 0)
+      frame++;
+    resident++;
+  } else {
+    frame = mru_head;
+    while (frame >= 0 && frames[frame].pin_count != 0)
+      frame = frames[frame].older;
+
+    if (frame < 0)
+      throw std::runtime_error("Everything is pinned!");
+
+    tracer.record(TraceEvent::Evict, frames[frame].block_id);
+    metrics.buffer_evictions.add();
+    if (frames[frame].dirty_bit)
+      write_frame(frame);
+    page_table.erase(frames[frame].block_id);
+    unlink(frame);
+  }
+
+  frames[frame] = {block_id};
+  frames[frame].accesses = 1;
+  read_frame(frame);
+  page_table.insert(block_id, frame);
+  push_front(frame);
+  return frame;
+}
+
+template <bool Readonly>
+std::conditional_t<Readonly, const char*, char*>
+BufferManager::load_sector(Address sector_address) {
+  std::lock_guard lock(mutex);
+  int frame = fetch(sector_address.address / global.block_size);
+  if constexpr (!Readonly)
+    frames[frame].dirty_bit = true;
+  return frame_data(frame) +
+         global.bytes * (sector_address.address % global.block_size);
 }
 template const char* BufferManager::load_sector<true>(Address sector_address);
 template char* BufferManager::load_sector<false>(Address sector_address);
 
-void BufferManager::print() const {
+template <bool Readonly>
+std::conditional_t<Readonly, const char*, char*>
+BufferManager::pin_sector(Address sector_address) {
+  auto block_id = sector_address.address / global.block_size;
+  std::lock_guard lock(mutex);
+  int frame = fetch(block_id);
+  tracer.record(TraceEvent::Pin, block_id);
+  frames[frame].pin_count++;
+  if constexpr (!Readonly)
+    frames[frame].dirty_bit = true;
+  return frame_data(frame) +
+         global.bytes * (sector_address.address % global.block_size);
+}
+template const char* BufferManager::pin_sector<true>(Address sector_address);
+template char* BufferManager::pin_sector<false>(Address sector_address);
+
+void BufferManager::print() {
+  std::lock_guard lock(mutex);
+  finish_warm_up();
   std::println("ID\tL/W\tDIRTY\tPINS\tMRU");
-  for (int idx{}; int frame_id : mru) {
-    const auto& frame = pool.at(frame_id);
-    std::println("{}\t{}\t{}\t{}\t{}", frame_id, frame.dirty_bit ? 'W' : 'L',
-                 frame.dirty_bit, frame.pin_count, idx++);
+  for (int idx{}, frame = mru_head; frame >= 0;
+       frame = frames[frame].older) {
+    const auto& descriptor = frames[frame];
+    std::println("{}\t{}\t{}\t{}\t{}", descriptor.block_id,
+                 descriptor.dirty_bit ? 'W' : 'L', descriptor.dirty_bit,
+                 descriptor.pin_count, idx++);
   }
-  std::println("Total access {}\tHits {}", total_access, hits);
-  std::println("Hit rate {}%", static_cast<float>(hits) * 100 / total_access);
+  std::println("Total access {}\tHits {}", counters.accesses, counters.hits);
+  std::println("Hit rate {}%",
+               static_cast<float>(counters.hits) * 100 / counters.accesses);
 }
 
-void BufferManager::pin(Address sector_address) {
-  int block_id = sector_address.address / global.block_size;
-  if constexpr (log_info)
-    std::println("Pinning {}", block_id);
-  if (auto it = pool.find(block_id); it != pool.end()) {
-    it->second.pin_count++;
+void BufferManager::reset() {
+  std::lock_guard lock(mutex);
+  if (warmer.joinable()) {
+    warmer.request_stop();
+    warmer.join();
   }
-  if constexpr (log_info)
-    print();
+  frames = {};
+  page_table.clear();
+  mru_head = -1;
+  resident = 0;
+  arena.reset();
+  scheduler.reset();
+  extents.reset();
+  counters = {};
 }
 
 void BufferManager::unpin(Address sector_address) {
-  int block_id = sector_address.address / global.block_size;
-  if constexpr (log_info)
-    std::println("Unpinning {}", block_id);
-  if (auto it = pool.find(block_id); it != pool.end()) {
-    if (it->second.pin_count > 0)
-      it->second.pin_count--;
-  }
-  if constexpr (log_info)
-    print();
+  auto block_id = sector_address.address / global.block_size;
+  tracer.record(TraceEvent::Unpin, block_id);
+  std::lock_guard lock(mutex);
+  if (int frame = page_table.find(block_id); frame >= 0)
+    if (frames[frame].pin_count > 0)
+      frames[frame].pin_count--;
 }
@@ -0,0 +1,163 @@
+#include "Command.hpp"
+#include "Errors.hpp"
+#include "Metrics.hpp"
+#include "Settings.hpp"
+#include "Table.hpp"
+#include "Trace.hpp"
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+std::shared_ptr<const Statement> cached_statement(Session& session,
+                                                  std::string_view line) {
+  auto key = normalize_statement(line);
+  if (auto statement = session.plan_cache.find(key))
+    return statement;
+  std::shared_ptr<const Statement> parsed = parse_statement(key);
+  if (!parsed)
+    return nullptr;
+  if (parsed->parameter_count > 0) {
+    errors() << "Los parámetros $N solo se admiten con PREPARE\n";
+    return nullptr;
+  }
+  session.plan_cache.insert(std::move(key), parsed);
+  return parsed;
+}
+
+void run_command(std::string_view line, Session& session, std::ostream& out) {
+  std::stringstream ss{std::string(line)};
+  std::string word;
+  ss >> word;
+  if (word == "LOAD") {
+    std::string name, APPEND;
+    ss >> name >> APPEND;
+    if (load_csv(name, APPEND == "APPEND"))
+      notices() << "\tSe cargó la tabla " << name << " exitosamente\n";
+  } else if (word == "INSERT") {
+    std::string INTO, table_name, VALUES;
+    ss >> INTO >> table_name >> VALUES;
+    if (INTO == "INTO" && VALUES == "VALUES") {
+      std::string values;
+      std::getline(ss, values, '\n');
+      if (auto inserted = insert_values(table_name, values))
+        notices() << "\tSe insertaron " << *inserted << " registros en "
+                  << table_name << '\n';
+    }
+  } else if (word == "SELECT" || word == "DELETE" || word == "EXPLAIN") {
+    if (auto statement = cached_statement(session, line))
+      execute(*statement, out);
+  } else if (word == "PREPARE") {
+    std::string name, AS;
+    ss >> name >> AS;
+    std::string text;
+    std::getline(ss, text, '\n');
+    if (AS != "AS") {
+      errors() << "Uso: PREPARE nombre AS sentencia\n";
+      return;
+    }
+    if (auto statement = parse_statement(normalize_statement(text))) {
+      session.prepared[name] = std::move(statement);
+      notices() << "\tSe preparó la sentencia " << name << '\n';
+    }
+  } else if (word == "EXECUTE") {
+    // EXECUTE nombre(valor, ...), los paréntesis pueden ir separados
+    std::string rest;
+    std::getline(ss, rest, '\n');
+    auto open = rest.find('(');
+    auto close = rest.rfind(')');
+    std::stringstream name_ss{rest.substr(0, open)};
+    std::string name;
+    name_ss >> name;
+    auto it = session.prepared.find(name);
+    if (it == session.prepared.end()) {
+      errors() << "Sentencia " << name << " no existe\n";
+      return;
+    }
+    std::string_view values;
+    if (open != std::string::npos && close != std::string::npos &&
+        open < close)
+      values = std::string_view(rest).substr(open + 1, close - open - 1);
+    if (bind_parameters(*it->second, values))
+      execute(*it->second, out);
+  } else if (word == "DEALLOCATE") {
+    std::string name;
+    ss >> name;
+    if (!session.prepared.erase(name))
+      errors() << "Sentencia " << name << " no existe\n";
+  } else if (word == "VACUUM") {
+    std::string name;
+    ss >> name;
+    int freed = vacuum(name);
+    notices() << "\tSe liberaron " << freed << " sectores de la tabla "
+              << name << '\n';
+  } else if (word == "SET") {
+    std::string name;
+    double value;
+    ss >> name >> value;
+    if (name == "WORK_MEMORY" && ss)
+      settings.work_memory = static_cast<std::size_t>(value);
+    else if (name == "AUTOVACUUM" && ss)
+      settings.autovacuum_fill_factor = value;
+    else if (name == "DIRECT_IO" && ss)
+      settings.direct_io = value != 0;
+    else if (name == "PARALLEL_IO" && ss)
+      settings.parallel_io = value != 0;
+    else if (name == "COMPRESSION" && ss)
+      settings.compression = value != 0;
+  } else if (word == "TRACE") {
+    std::string action, file_name;
+    ss >> action >> file_name;
+    if (action == "ON")
+      tracer.start();
+    else if (action == "OFF")
+      tracer.stop();
+    else if (action == "DUMP") {
+      if (file_name.empty())
+        file_name = "trace.json";
+      std::ofstream file(file_name);
+      tracer.dump(file);
+      notices() << "\tSe escribió la traza en " << file_name << '\n';
+    }
+  } else if (word == "STATS") {
+    std::string DUMP, file_name;
+    ss >> DUMP >> file_name;
+    if (DUMP == "DUMP") {
+      if (file_name.empty())
+        file_name = "metrics.prom";
+      std::ofstream file(file_name);
+      metrics.write_prometheus(file);
+      notices() << "\tSe escribieron las métricas en " << file_name << '\n';
+    } else
+      metrics.print(out);
+  } else if (word == "INFO")
+    disk_info(out);
+}
+
+CommandResult capture_command(
+    std::string line, const std::function<void(std::ostream&)>& run) {
+  CommandResult result;
+  result.line = std::move(line);
+  std::ostringstream output, notice, error;
+  auto start = std::chrono::steady_clock::now();
+  {
+    StreamCapture capture_notices(notice_output, notice);
+    StreamCapture capture_errors(error_output, error);
+    QueryTrace trace(result.line);
+    LatencyTimer timer(metrics.query_latency);
+    try {
+      run(output);
+    } catch (const std::exception& e) {
+      errors() << "Error: " << e.what() << '\n';
+    }
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  result.output = std::move(output).str();
+  result.notices = std::move(notice).str();
+  result.errors = std::move(error).str();
+  result.failed = !result.errors.empty();
+  return result;
+}
@@ -0,0 +1,129 @@
+#include "Compression.hpp"
+#include "Disk.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+constexpr char block_magic[4] = {'Z', 'R', 'L', '1'};
+
+struct BlockHeader {
+  char magic[4];
+  std::uint32_t encoded_bytes;
+};
+
+// Cada tramo es una corrida de ceros seguida de bytes literales
+struct Token {
+  std::uint16_t zeros;
+  std::uint16_t literals;
+};
+
+// Corridas más cortas que esto se dejan dentro del literal, cortarlo
+// costaría una cabecera de tramo más de lo que ahorra
+constexpr std::size_t min_run = sizeof(Token);
+constexpr std::size_t max_length = UINT16_MAX;
+
+std::size_t zero_run(std::span<const char> data, std::size_t from,
+                     std::size_t limit) {
+  auto end = std::min(data.size(), from + limit);
+  auto position = from;
+  while (position < end && data[position] == 0)
+    position++;
+  return position - from;
+}
+} // namespace
+
+std::size_t compress_block(std::span<const char> input,
+                           std::span<char> output) {
+  auto written = sizeof(BlockHeader);
+  if (output.size() < written)
+    return 0;
+
+  for (std::size_t position = 0; position < input.size();) {
+    auto zeros = zero_run(input, position, max_length);
+    position += zeros;
+    auto start = position;
+    while (position < input.size() && position - start < max_length &&
+           zero_run(input, position, min_run) < min_run)
+      position++;
+    Token token{static_cast<std::uint16_t>(zeros),
+                static_cast<std::uint16_t>(position - start)};
+    if (written + sizeof(token) + token.literals > output.size())
+      return 0;
+    std::memcpy(output.data() + written, &token, sizeof(token));
+    written += sizeof(token);
+    std::memcpy(output.data() + written, input.data() + start, token.literals);
+    written += token.literals;
+  }
+
+  BlockHeader header{{}, static_cast<std::uint32_t>(written)};
+  std::ranges::copy(block_magic, header.magic);
+  std::memcpy(output.data(), &header, sizeof(header));
+  return written;
+}
+
+void decompress_block(std::span<const char> input, std::span<char> output) {
+  BlockHeader header;
+  if (input.size() < sizeof(header))
+    throw std::runtime_error("Bloque comprimido truncado");
+  std::memcpy(&header, input.data(), sizeof(header));
+  if (!std::ranges::equal(header.magic, block_magic) ||
+      header.encoded_bytes > input.size())
+    throw std::runtime_error("Bloque comprimido inválido");
+
+  std::size_t read = sizeof(header), produced = 0;
+  while (read < header.encoded_bytes) {
+    Token token;
+    if (read + sizeof(token) > header.encoded_bytes)
+      throw std::runtime_error("Bloque comprimido inválido");
+    std::memcpy(&token, input.data() + read, sizeof(token));
+    read += sizeof(token);
+    if (read + token.literals > header.encoded_bytes ||
+        produced + token.zeros + token.literals > output.size())
+      throw std::runtime_error("Bloque comprimido inválido");
+    std::memset(output.data() + produced, 0, token.zeros);
+    produced += token.zeros;
+    std::memcpy(output.data() + produced, input.data() + read, token.literals);
+    produced += token.literals;
+    read += token.literals;
+  }
+  if (produced != output.size())
+    throw std::runtime_error("Bloque comprimido inválido");
+}
+
+ExtentMap::ExtentMap() :
+    stored(global.total_sectors() / global.block_size) {
+  auto path = disk_path / "extents";
+  file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (file < 0)
+    throw std::system_error(errno, std::generic_category(), path);
+  // Un mapa más corto que el disco (o recién creado) deja en 0 los
+  // bloques que faltan, que es lo que son: sectores sin comprimir
+  auto bytes = static_cast<ssize_t>(stored.size() * sizeof(stored[0]));
+  if (::pread(file, stored.data(), bytes, 0) < 0) {
+    auto error = errno;
+    ::close(file);
+    throw std::system_error(error, std::generic_category(), path);
+  }
+}
+
+ExtentMap::~ExtentMap() {
+  ::close(file);
+}
+
+int ExtentMap::stored_sectors(std::int64_t block_id) const {
+  return stored[block_id] ? stored[block_id] : global.block_size;
+}
+
+void ExtentMap::set(std::int64_t block_id, int sectors) {
+  std::uint16_t entry = sectors < global.block_size ? sectors : 0;
+  if (stored[block_id] == entry)
+    return;
+  stored[block_id] = entry;
+  if (::pwrite(file, &entry, sizeof(entry), block_id * sizeof(entry)) < 0)
+    throw std::system_error(errno, std::generic_category(), "extents");
+}
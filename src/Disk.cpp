@@ -1,10 +1,50 @@
 #include "Disk.hpp"
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <stdexcept>
 
 namespace fs = std::filesystem;
 
-fs::path Address::to_path() const {
-  int address = this->address;
+namespace {
+// El superbloque va en un archivo propio: para leer cualquier sector
+// primero hay que conocer su tamaño
+// DISCO02: los sectores de datos guardan la versión de cada registro
+// DISCO03: los campos de la cabecera de una tabla van alineados
+constexpr char superblock_magic[8] = "DISCO03";
+
+struct Superblock {
+  char magic[8];
+  DiskInfo geometry;
+};
+
+fs::path superblock_path() {
+  return disk_path / "superblock";
+}
+
+void validate(const DiskInfo& info) {
+  if (info.plates <= 0 || info.tracks <= 0 || info.sectors <= 0 ||
+      info.block_size <= 0)
+    throw std::invalid_argument("Geometría inválida");
+  // La cabecera de una tabla necesita al menos espacio para un par de
+  // columnas además de sus direcciones
+  if (info.bytes < 128)
+    throw std::invalid_argument("Los sectores deben tener al menos 128 bytes");
+  // Así cada sector del buffer empieza alineado para sus direcciones
+  if (info.bytes % alignof(Address) != 0)
+    throw std::invalid_argument(
+        "Los bytes por sector deben ser múltiplo de " +
+        std::to_string(alignof(Address)));
+  if (info.total_sectors() % info.block_size != 0)
+    throw std::invalid_argument(
+        "El número de sectores debe ser múltiplo del tamaño de bloque");
+}
+
+
+} // namespace
+
+SectorLocation Address::location() const {
+  auto address = this->address;
   auto plate = address % global.plates;
   address /= global.plates;
   auto sector = address % global.sectors;
@@ -12,13 +52,41 @@ fs::path Address::to_path() const {
   auto track = address % global.tracks;
   address /= global.tracks;
   auto surface = address % 2;
+  return {plate, surface, track, sector};
+}
 
+fs::path Address::to_path() const {
+  auto [plate, surface, track, sector] = location();
   return disk_path / ('p' + std::to_string(plate)) /
          ('f' + std::to_string(surface)) / ('t' + std::to_string(track)) /
          ('s' + std::to_string(sector));
 }
 
-void make_disk() {
+bool Address::format_path(std::span<char> buffer) const {
+  auto [plate, surface, track, sector] = location();
+  int written = std::snprintf(buffer.data(), buffer.size(),
+                              "%s/p%lld/f%lld/t%lld/s%lld", disk_path.c_str(),
+                              plate, surface, track, sector);
+  return written >= 0 && static_cast<std::size_t>(written) < buffer.size();
+}
+
+int* geometry_option(DiskInfo& info, std::string_view option) {
+  if (option == "--plates")
+    return &info.plates;
+  if (option == "--tracks")
+    return &info.tracks;
+  if (option == "--sectors")
+    return &info.sectors;
+  if (option == "--bytes")
+    return &info.bytes;
+  if (option == "--block-size")
+    return &info.block_size;
+  return nullptr;
+}
+
+void make_disk(const DiskInfo& info) {
+  validate(info);
+  global = info;
   fs::create_directory(disk_path);
   for (int plate = 0; plate < global.plates; plate++) {
     fs::path plate_path = disk_path / ("p" + std::to_string(plate));
@@ -37,4 +105,22 @@ void make_disk() {
       }
     }
   }
+
+  Superblock superblock{{}, global};
+  std::ranges::copy(superblock_magic, superblock.magic);
+  std::ofstream file(superblock_path(), std::ios::binary);
+  file.write(reinterpret_cast<const char*>(&superblock), sizeof(superblock));
+}
+
+void open_disk() {
+  std::ifstream file(superblock_path(), std::ios::binary);
+  Superblock superblock;
+  if (!file.read(reinterpret_cast<char*>(&superblock), sizeof(superblock)) ||
+      !std::ranges::equal(superblock.magic, superblock_magic))
+    throw std::runtime_error("El disco no tiene un superbloque " +
+                             std::string(superblock_magic) +
+                             ", bórrelo (" + disk_path.string() +
+                             ") para volver a crearlo");
+  validate(superblock.geometry);
+  global = superblock.geometry;
 }
@@ -0,0 +1,63 @@
+#include "Explain.hpp"
+#include "Sector.hpp"
+#include <iomanip>
+#include <ostream>
+
+std::size_t QueryPlan::add(std::string description,
+                           std::vector<std::size_t> inputs) {
+  auto& stage = stages.emplace_back();
+  stage.description = std::move(description);
+  stage.inputs = std::move(inputs);
+  return stages.size() - 1;
+}
+
+std::size_t QueryPlan::enter(std::size_t stage) {
+  if (!analyzing())
+    return active;
+  auto now = Clock::now();
+  auto buffer = buffer_manager.stats();
+  if (active != no_stage) {
+    stages[active].seconds +=
+        std::chrono::duration<double>(now - since).count();
+    stages[active].buffer += buffer - since_buffer;
+  }
+  since = now;
+  since_buffer = buffer;
+  return std::exchange(active, stage);
+}
+
+void QueryPlan::print_stage(std::ostream& os, std::size_t stage,
+                            int depth) const {
+  const auto& info = stages[stage];
+  std::string indent(depth * 4, ' ');
+  os << indent << (depth ? "-> " : "") << info.description << '\n';
+  indent += depth ? "     " : "  ";
+  for (const auto& detail : info.details)
+    os << indent << detail << '\n';
+  if (analyzing()) {
+    os << indent << "Tiempo: " << info.seconds * 1e3 << " ms, filas "
+       << info.rows_examined << " examinadas / " << info.rows_emitted
+       << " emitidas, " << info.sectors << " sectores\n";
+    os << indent << "Buffer: " << info.buffer.hits << " aciertos, "
+       << info.buffer.misses() << " fallos, " << info.buffer.bytes_read
+       << " bytes leídos, " << info.buffer.bytes_written
+       << " bytes escritos\n";
+  }
+  for (auto input : info.inputs)
+    print_stage(os, input, depth + 1);
+}
+
+void QueryPlan::print(std::ostream& os) const {
+  if (stages.empty())
+    return;
+  auto flags = os.flags();
+  auto precision = os.precision(3);
+  os << std::fixed;
+  print_stage(os, stages.size() - 1, 0);
+  if (analyzing())
+    os << "Tiempo total: "
+       << std::chrono::duration<double>(Clock::now() - started).count() * 1e3
+       << " ms\n";
+  os.flags(flags);
+  os.precision(precision);
+}
@@ -1,6 +1,7 @@
 #include "Interpreter.hpp"
 #include <cstring>
 #include <numeric>
+#include <ostream>
 #include <ranges>
 
 namespace Db {
@@ -14,6 +15,19 @@ struct ValueNode final : public Node {
   Value evaluate(const char*, const Column*) const override {
     return number;
   }
+  void print(std::ostream& os, const Column*) const override {
+    visit(
+        [&os](auto&& value) {
+          using T = std::decay_t<decltype(value)>;
+          if constexpr (std::is_same_v<T, bool>)
+            os << (value ? "true" : "false");
+          else if constexpr (requires { os << value; })
+            os << value;
+          else
+            os << '"' << value.data() << '"';
+        },
+        number);
+  }
 };
 
 struct Variable final : public Node {
@@ -31,6 +45,29 @@ struct Variable final : public Node {
           return arg;
         });
   }
+  void print(std::ostream& os, const Column* columns) const override {
+    os << columns[index].name.data();
+  }
+};
+
+// Marcador $N de una sentencia preparada, vale lo que se le pasó en el
+// último EXECUTE
+struct Parameter final : public Node {
+  const std::size_t index;
+  const Parameters& parameters;
+
+  Parameter(std::size_t _index, const Parameters& _parameters) :
+      index{_index},
+      parameters{_parameters} {}
+  ~Parameter() override = default;
+  Value evaluate(const char*, const Column*) const override {
+    if (index >= parameters.size())
+      throw std::invalid_argument("Syntax error: Unbound parameter");
+    return parameters[index];
+  }
+  void print(std::ostream& os, const Column*) const override {
+    os << '$' << index + 1;
+  }
 };
 
 template <class Func>
@@ -53,10 +90,12 @@ struct Operation final : public Node {
   };
   const NodePtr left;
   const NodePtr right;
+  const std::string_view symbol;
 
-  Operation(NodePtr&& _left, NodePtr&& _right) :
+  Operation(NodePtr&& _left, NodePtr&& _right, std::string_view _symbol) :
       left(std::move(_left)),
-      right(std::move(_right)) {}
+      right(std::move(_right)),
+      symbol(_symbol) {}
   virtual ~Operation() override = default;
   // Evalúa el nodo llamando al funtor con doas argumentos
   Value evaluate(const char* record, const Column* context) const override {
@@ -64,14 +103,22 @@ struct Operation final : public Node {
     auto rhs = right->evaluate(record, context);
     return visit(Visitor, std::move(lhs), std::move(rhs));
   }
+  void print(std::ostream& os, const Column* context) const override {
+    os << '(';
+    left->print(os, context);
+    os << ' ' << symbol << ' ';
+    right->print(os, context);
+    os << ')';
+  }
 };
 
 // Función auxiliar para crear nodos de operaciones
-using NodeFactory = NodePtr (*)(NodePtr&&, NodePtr&&);
+using NodeFactory = NodePtr (*)(NodePtr&&, NodePtr&&, std::string_view);
 template <typename T>
 constexpr NodeFactory op_factory =
-    [](NodePtr&& left, NodePtr&& right) -> NodePtr {
-  return std::make_unique<Operation<T>>(std::move(left), std::move(right));
+    [](NodePtr&& left, NodePtr&& right, std::string_view symbol) -> NodePtr {
+  return std::make_unique<Operation<T>>(std::move(left), std::move(right),
+                                        symbol);
 };
 
 struct OperationInfo {
@@ -158,7 +205,8 @@ Value::Variant parse_as_value(std::string&& expression) {
   return std::stol(expression);
 }
 
-NodePtr makeTree(std::string&& expression, std::span<const Column> columns) {
+NodePtr makeTree(std::string&& expression, std::span<const Schema> schemas,
+                 const Parameters* parameters) {
   while (expression.front() == '(' && expression.back() == ')')
     if (balanced_parenthesis(expression))
       expression = expression.substr(1, expression.length() - 2);
@@ -167,25 +215,70 @@ NodePtr makeTree(std::string&& expression, std::span<const Column> columns) {
 
   auto [pos, op] = find_lowest(expression);
   if (pos == std::string_view::npos) {
-    for (const auto& [idx, column] : std::views::enumerate(columns)) {
-      auto name = column.name.data();
-      if (std::strcmp(name, expression.c_str()) == 0)
-        return std::make_unique<Variable>(idx);
+    if (auto idx = findColumn(schemas, expression))
+      return std::make_unique<Variable>(*idx);
+    if (expression.front() == '$') {
+      auto number = std::stoul(expression.substr(1));
+      if (!parameters || number == 0)
+        throw std::invalid_argument("Syntax error: Unexpected parameter");
+      return std::make_unique<Parameter>(number - 1, *parameters);
     }
     return std::make_unique<ValueNode>(parse_as_value(std::move(expression)));
   }
 
-  auto leftNode = makeTree(expression.substr(0, pos), columns);
-  auto rightNode = makeTree(expression.substr(pos + op.name.size()), columns);
-  return op.factory(std::move(leftNode), std::move(rightNode));
+  auto leftNode = makeTree(expression.substr(0, pos), schemas, parameters);
+  auto rightNode =
+      makeTree(expression.substr(pos + op.name.size()), schemas, parameters);
+  return op.factory(std::move(leftNode), std::move(rightNode), op.name);
 }
 } // namespace
 
+std::optional<std::size_t> findColumn(std::span<const Schema> schemas,
+                                      std::string_view name) {
+  std::string_view table;
+  if (auto dot = name.find('.'); dot != std::string_view::npos) {
+    table = name.substr(0, dot);
+    name = name.substr(dot + 1);
+  }
+
+  std::optional<std::size_t> found;
+  std::size_t offset = 0;
+  for (const auto& schema : schemas) {
+    if (table.empty() || table == schema.table) {
+      for (const auto& [idx, column] : std::views::enumerate(schema.columns)) {
+        if (name != column.name.data())
+          continue;
+        if (found)
+          throw std::invalid_argument("Syntax error: Ambiguous column");
+        found = offset + idx;
+      }
+    }
+    offset += schema.columns.size();
+  }
+  return found;
+}
+
+std::unique_ptr<Node> parseExpression(std::string_view expression,
+                                      std::span<const Column> columns,
+                                      const Parameters* parameters) {
+  const Schema schema{{}, columns};
+  return parseExpression(expression, {&schema, 1}, parameters);
+}
+
 std::unique_ptr<Node> parseExpression(std::string_view _expression,
-                                      std::span<const Column> columns) {
+                                      std::span<const Schema> schemas,
+                                      const Parameters* parameters) {
   std::string expression{_expression};
   std::erase(expression, ' ');
-  auto tree = makeTree(std::move(expression), columns);
+  auto tree = makeTree(std::move(expression), schemas, parameters);
   return tree;
 }
+
+Value parseLiteral(std::string_view literal) {
+  auto first = literal.find_first_not_of(' ');
+  auto last = literal.find_last_not_of(' ');
+  if (first == std::string_view::npos)
+    throw std::invalid_argument("Syntax error: Empty literal");
+  return parse_as_value(std::string(literal.substr(first, last - first + 1)));
+}
 } // namespace Db
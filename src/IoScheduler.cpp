@@ -0,0 +1,138 @@
+#include "IoScheduler.hpp"
+#include "Settings.hpp"
+#include "Trace.hpp"
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <system_error>
+#include <unistd.h>
+
+void transfer_sector(Address sector_address, char* data, bool write) {
+  tracer.record(write ? TraceEvent::SectorWrite : TraceEvent::SectorRead,
+                sector_address.address);
+  std::array<char, PATH_MAX> path;
+  if (!sector_address.format_path(path))
+    throw std::runtime_error("Ruta de sector demasiado larga");
+
+  // Si el sistema de archivos o el tamaño del sector no admiten
+  // O_DIRECT se repite la operación a través del caché del sistema
+  auto flags = write ? O_WRONLY : O_RDONLY;
+  for (bool direct : {settings.direct_io, false}) {
+    if (direct && global.bytes % 512 != 0)
+      continue;
+    int fd = ::open(path.data(), flags | (direct ? O_DIRECT : 0));
+    if (fd < 0) {
+      if (direct)
+        continue;
+      throw std::system_error(errno, std::generic_category(), path.data());
+    }
+    auto done = write ? ::pwrite(fd, data, global.bytes, 0)
+                      : ::pread(fd, data, global.bytes, 0);
+    auto error = errno;
+    ::close(fd);
+    if (done < 0 && direct && error == EINVAL)
+      continue;
+    if (done < 0)
+      throw std::system_error(error, std::generic_category(), path.data());
+    if (!write)
+      std::memset(data + done, 0, global.bytes - done);
+    return;
+  }
+}
+
+void IoBatch::add() {
+  std::lock_guard lock(mutex);
+  pending++;
+}
+
+void IoBatch::complete(std::exception_ptr failure) {
+  std::lock_guard lock(mutex);
+  if (failure && !error)
+    error = failure;
+  if (--pending == 0)
+    finished.notify_all();
+}
+
+void IoBatch::wait() {
+  std::unique_lock lock(mutex);
+  finished.wait(lock, [this] {
+    return pending == 0;
+  });
+  if (error)
+    std::rethrow_exception(error);
+}
+
+IoScheduler::IoScheduler(int plates) {
+  for (int plate = 0; plate < plates; plate++) {
+    auto& queue = *queues.emplace_back(std::make_unique<Queue>());
+    queue.worker = std::jthread([&queue](std::stop_token stop) {
+      serve(stop, queue);
+    });
+  }
+}
+
+IoScheduler::~IoScheduler() {
+  // Los jthread se detienen y se esperan al destruir cada cola
+  for (auto& queue : queues)
+    queue->worker.request_stop();
+}
+
+void IoScheduler::submit(const IoRequest& request) {
+  request.batch->add();
+  auto& queue = *queues[request.address.location().plate];
+  {
+    std::lock_guard lock(queue.mutex);
+    queue.pending.push_back(request);
+  }
+  queue.ready.notify_one();
+}
+
+IoRequest IoScheduler::next_request(Queue& queue) {
+  auto position = [](const IoRequest& request) {
+    auto location = request.address.location();
+    return std::pair{location.track, location.sector};
+  };
+  auto best = queue.pending.end();
+  for (int turn = 0; turn < 2 && best == queue.pending.end(); turn++) {
+    for (auto it = queue.pending.begin(); it != queue.pending.end(); it++) {
+      auto at = position(*it);
+      bool ahead = queue.ascending ? at.first >= queue.head_track
+                                   : at.first <= queue.head_track;
+      if (!ahead)
+        continue;
+      if (best == queue.pending.end() ||
+          (queue.ascending ? at < position(*best) : at > position(*best)))
+        best = it;
+    }
+    if (best == queue.pending.end())
+      queue.ascending = !queue.ascending;
+  }
+
+  auto request = *best;
+  queue.head_track = position(request).first;
+  *best = queue.pending.back();
+  queue.pending.pop_back();
+  return request;
+}
+
+void IoScheduler::serve(std::stop_token stop, Queue& queue) {
+  while (true) {
+    IoRequest request;
+    {
+      std::unique_lock lock(queue.mutex);
+      if (!queue.ready.wait(lock, stop, [&queue] {
+            return !queue.pending.empty();
+          }))
+        return;
+      request = next_request(queue);
+    }
+    try {
+      transfer_sector(request.address, request.data, request.write);
+      request.batch->complete();
+    } catch (...) {
+      request.batch->complete(std::current_exception());
+    }
+  }
+}
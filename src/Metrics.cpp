@@ -0,0 +1,153 @@
+#include "Metrics.hpp"
+#include "Sector.hpp"
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+
+namespace {
+double buffer_accesses() {
+  return buffer_manager.stats().accesses;
+}
+
+double buffer_hits() {
+  return buffer_manager.stats().hits;
+}
+
+double buffer_hit_ratio() {
+  auto stats = buffer_manager.stats();
+  return stats.accesses ? static_cast<double>(stats.hits) / stats.accesses : 0;
+}
+
+double buffer_capacity() {
+  return BufferManager::capacity;
+}
+
+double rows_per_second() {
+  auto seconds = metrics.scan_latency.sum();
+  return seconds > 0 ? metrics.rows_scanned.get() / seconds : 0;
+}
+
+// Se definen después de metrics, así se registran cuando ya existe
+SampledMetric sampled_metrics[] = {
+    {metrics, "disco_buffer_accesses_total",
+     "Accesos a sectores a través del buffer", "counter", buffer_accesses},
+    {metrics, "disco_buffer_hits_total",
+     "Accesos resueltos sin leer del disco", "counter", buffer_hits},
+    {metrics, "disco_buffer_hit_ratio", "Fracción de accesos con acierto",
+     "gauge", buffer_hit_ratio},
+    {metrics, "disco_buffer_capacity_frames", "Marcos del buffer", "gauge",
+     buffer_capacity},
+    {metrics, "disco_scan_rows_per_second",
+     "Registros por segundo en los recorridos secuenciales", "gauge",
+     rows_per_second},
+};
+} // namespace
+
+Counter::Counter(MetricRegistry& registry, std::string_view _name,
+                 std::string_view _help) :
+    name{_name},
+    help{_help} {
+  registry.counters.push_back(this);
+}
+
+SampledMetric::SampledMetric(MetricRegistry& registry, std::string_view _name,
+                             std::string_view _help, std::string_view _type,
+                             double (*_sample)()) :
+    name{_name},
+    help{_help},
+    type{_type},
+    sample{_sample} {
+  registry.sampled.push_back(this);
+}
+
+Histogram::Histogram(MetricRegistry& registry, std::string_view _name,
+                     std::string_view _help) :
+    name{_name},
+    help{_help} {
+  registry.histograms.push_back(this);
+}
+
+void Histogram::observe(double seconds) {
+  auto micros = static_cast<std::uint64_t>(std::ceil(seconds * 1e6));
+  int idx = micros <= 1 ? 0 : std::bit_width(micros - 1);
+  buckets[std::min(idx, bucket_count)].fetch_add(1, std::memory_order_relaxed);
+  count.fetch_add(1, std::memory_order_relaxed);
+  sum_ns.fetch_add(static_cast<std::int64_t>(seconds * 1e9),
+                   std::memory_order_relaxed);
+}
+
+double Histogram::upper_bound(int bucket) {
+  if (bucket >= bucket_count)
+    return std::numeric_limits<double>::infinity();
+  return 1e-6 * static_cast<double>(std::uint64_t{1} << bucket);
+}
+
+double Histogram::quantile(double q) const {
+  auto rank = q * total();
+  double cumulative = 0;
+  for (int idx = 0; idx < size(); idx++) {
+    auto in_bucket = bucket(idx);
+    if (in_bucket == 0 || cumulative + in_bucket < rank) {
+      cumulative += in_bucket;
+      continue;
+    }
+    auto lower = idx ? upper_bound(idx - 1) : 0;
+    auto upper = upper_bound(idx);
+    if (std::isinf(upper))
+      return lower;
+    return lower + (upper - lower) * (rank - cumulative) / in_bucket;
+  }
+  return 0;
+}
+
+void MetricRegistry::print(std::ostream& os) const {
+  for (const auto* counter : counters)
+    os << counter->name << ": " << counter->get() << '\n';
+  for (const auto* metric : sampled)
+    os << metric->name << ": " << metric->sample() << '\n';
+  for (const auto* histogram : histograms) {
+    auto count = histogram->total();
+    os << histogram->name << ": " << count << " observaciones";
+    if (count)
+      os << ", promedio " << histogram->sum() / count * 1e3 << " ms, p50 "
+         << histogram->quantile(0.5) * 1e3 << " ms, p90 "
+         << histogram->quantile(0.9) * 1e3 << " ms, p99 "
+         << histogram->quantile(0.99) * 1e3 << " ms";
+    os << '\n';
+  }
+}
+
+void MetricRegistry::write_prometheus(std::ostream& os) const {
+  auto precision = os.precision(12);
+  auto header = [&os](std::string_view name, std::string_view help,
+                      std::string_view type) {
+    os << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' '
+       << type << '\n';
+  };
+  for (const auto* counter : counters) {
+    header(counter->name, counter->help, "counter");
+    os << counter->name << ' ' << counter->get() << '\n';
+  }
+  for (const auto* metric : sampled) {
+    header(metric->name, metric->help, metric->type);
+    os << metric->name << ' ' << metric->sample() << '\n';
+  }
+  for (const auto* histogram : histograms) {
+    header(histogram->name, histogram->help, "histogram");
+    std::int64_t cumulative = 0;
+    for (int idx = 0; idx < Histogram::size(); idx++) {
+      cumulative += histogram->bucket(idx);
+      os << histogram->name << "_bucket{le=\"";
+      if (idx + 1 == Histogram::size())
+        os << "+Inf";
+      else
+        os << Histogram::upper_bound(idx);
+      os << "\"} " << cumulative << '\n';
+    }
+    os << histogram->name << "_sum " << histogram->sum() << '\n'
+       << histogram->name << "_count " << histogram->total() << '\n';
+  }
+  os.precision(precision);
+}
@@ -0,0 +1,61 @@
+#include "Pipeline.hpp"
+#include <cstring>
+#include <ostream>
+
+Projection::Projection(std::span<const Db::Column> columns,
+                       std::span<const std::size_t> selected) {
+  std::vector<std::size_t> offsets;
+  std::size_t offset = 0;
+  for (const auto& column : columns) {
+    offsets.push_back(offset);
+    offset += size_of_type(column.type);
+  }
+  for (auto idx : selected) {
+    auto size = size_of_type(columns[idx].type);
+    fields.emplace_back(offsets[idx], size);
+    record_size += size;
+  }
+}
+
+RecordBatch Projection::apply(const RecordBatch& batch) {
+  buffer.resize(batch.records.size() * record_size);
+  records.clear();
+  auto target = buffer.data();
+  for (auto record : batch.records) {
+    records.push_back(target);
+    for (auto [offset, size] : fields) {
+      std::memcpy(target, record + offset, size);
+      target += size;
+    }
+  }
+  return {NullAddress, records};
+}
+
+void print_record(std::ostream& os, const char* record,
+                  std::span<const Db::Column> columns) {
+  for (const auto& column : columns) {
+    visit_type(record, column.type, [&os](auto&& arg) {
+      if constexpr (requires { os << arg; })
+        os << arg;
+      else
+        os << arg.data();
+    });
+    os << '#';
+    record += size_of_type(column.type);
+  }
+  os << '\n';
+}
+
+bool OutputSink::operator()(const RecordBatch& batch) {
+  StageScope scope(plan, stage);
+  for (auto record : batch.records) {
+    plan[stage].rows_examined++;
+    plan[stage].rows_emitted++;
+    // ANALYZE ejecuta la consulta pero solo muestra el plan
+    if (!plan.analyzing())
+      print_record(out, record, columns);
+    if (--remaining == 0)
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,36 @@
+#include "Sector.hpp"
+#include "Metrics.hpp"
+#include <array>
+#include <new>
+
+BufferManager buffer_manager;
+
+namespace {
+// Sector desde el cual se continúa la búsqueda de espacio libre
+std::int64_t allocation_cursor = 0;
+
+std::array<std::shared_mutex, 64> latches;
+} // namespace
+
+std::shared_mutex& sector_latch(Address address) {
+  return latches[static_cast<std::uint64_t>(address.address) % latches.size()];
+}
+
+Address allocate_sector() {
+  auto total_sectors = global.total_sectors();
+  for (std::int64_t scanned = 0; scanned < total_sectors; scanned++) {
+    Address address = {allocation_cursor};
+    allocation_cursor = (allocation_cursor + 1) % total_sectors;
+    if (SectorHandle(address).next_sector().address == 0) {
+      metrics.allocation_scans.add(scanned + 1);
+      metrics.allocations.add();
+      return address;
+    }
+  }
+  metrics.allocation_scans.add(total_sectors);
+  throw std::bad_alloc();
+}
+
+void free_sector(Address sector_address) {
+  SectorHandle<false>(sector_address).next_sector() = {0};
+}
@@ -0,0 +1,312 @@
+#include "Server.hpp"
+#include "Protocol.hpp"
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+// Las lecturas que se pueden ejecutar a la vez y las escrituras que solo
+// crean o marcan versiones lo toman compartido: las lecturas ven su
+// instantánea y las escrituras se ordenan entre ellas en transactions.
+// El resto (compactar, crear tablas, ordenar en disco, cambiar la
+// configuración) lo toma en exclusiva
+std::shared_mutex engine_mutex;
+
+// Una línea más larga sin salto de línea se considera un error del cliente
+constexpr std::size_t max_line = 1 << 20;
+
+int check(int result, const char* what) {
+  if (result < 0)
+    throw std::system_error(errno, std::generic_category(), what);
+  return result;
+}
+
+sockaddr_un socket_address(const std::filesystem::path& path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.native().size() >= sizeof(address.sun_path))
+    throw std::runtime_error("Ruta del socket demasiado larga");
+  std::strcpy(address.sun_path, path.c_str());
+  return address;
+}
+
+void run_shared(std::string_view line, Session& session, std::ostream& out) {
+  std::stringstream ss{std::string(line)};
+  std::string word, name, APPEND;
+  ss >> word >> name >> APPEND;
+  if (word == "SELECT" || word == "DELETE") {
+    std::shared_lock shared(engine_mutex);
+    auto statement = cached_statement(session, line);
+    if (!statement)
+      return;
+    if (statement->concurrent() || statement->versioned_write()) {
+      execute(*statement, out);
+      return;
+    }
+    shared.unlock();
+    std::unique_lock exclusive(engine_mutex);
+    execute(*statement, out);
+    return;
+  }
+  if (word == "INSERT" || (word == "LOAD" && APPEND == "APPEND")) {
+    std::shared_lock shared(engine_mutex);
+    run_command(line, session, out);
+    return;
+  }
+  std::unique_lock exclusive(engine_mutex);
+  run_command(line, session, out);
+}
+} // namespace
+
+Server::Server(std::filesystem::path path, int worker_count) :
+    socket_path{std::move(path)} {
+  // Las señales de fin se leen de un descriptor. Se bloquean antes de
+  // crear los hilos del grupo para que ellos las hereden bloqueadas
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+  signals = check(signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC), "signalfd");
+
+  auto address = socket_address(socket_path);
+  listener = check(socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                          0),
+                   "socket");
+  // Un socket que quedó de otro servidor se reemplaza solo si ya nadie
+  // lo atiende
+  if (std::filesystem::exists(socket_path)) {
+    int probe = check(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0),
+                      "socket");
+    bool in_use = connect(probe, reinterpret_cast<sockaddr*>(&address),
+                          sizeof(address)) == 0;
+    close(probe);
+    if (in_use)
+      throw std::runtime_error("Ya hay un servidor en " +
+                               socket_path.string());
+    std::filesystem::remove(socket_path);
+  }
+  check(bind(listener, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)),
+        socket_path.c_str());
+  check(listen(listener, SOMAXCONN), "listen");
+
+  epoll = check(epoll_create1(EPOLL_CLOEXEC), "epoll_create1");
+  wakeup = check(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), "eventfd");
+  for (int fd : {listener, wakeup, signals}) {
+    epoll_event event{EPOLLIN, {.fd = fd}};
+    check(epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event), "epoll_ctl");
+  }
+
+  for (int idx = 0; idx < worker_count; idx++)
+    workers.emplace_back([this](std::stop_token stop) {
+      work(stop);
+    });
+}
+
+Server::~Server() {
+  // Se espera a que terminen las sentencias en curso, las que quedaron
+  // en la cola se descartan
+  for (auto& worker : workers)
+    worker.request_stop();
+  workers.clear();
+  for (auto& [fd, client] : clients)
+    close(fd);
+  for (int fd : {listener, epoll, wakeup, signals})
+    close(fd);
+  std::filesystem::remove(socket_path);
+}
+
+void Server::run() {
+  std::array<epoll_event, 64> events;
+  for (bool running = true; running;) {
+    int count = epoll_wait(epoll, events.data(), events.size(), -1);
+    if (count < 0 && errno == EINTR)
+      continue;
+    check(count, "epoll_wait");
+    for (int idx = 0; idx < count; idx++) {
+      int fd = events[idx].data.fd;
+      if (fd == listener)
+        accept_clients();
+      else if (fd == wakeup)
+        finish_jobs();
+      else if (fd == signals)
+        running = false;
+      else if (auto it = clients.find(fd); it != clients.end()) {
+        auto& client = it->second;
+        if (events[idx].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+          read_client(client);
+        if (events[idx].events & EPOLLOUT)
+          write_client(client);
+        watch(client);
+        release(fd);
+      }
+    }
+  }
+}
+
+void Server::accept_clients() {
+  while (true) {
+    int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED)
+        return;
+      check(fd, "accept4");
+    }
+    auto& client = clients[fd];
+    client.fd = fd;
+    watch(client);
+  }
+}
+
+void Server::read_client(Client& client) {
+  std::array<char, 1 << 16> buffer;
+  while (!client.hangup) {
+    auto received = recv(client.fd, buffer.data(), buffer.size(), 0);
+    if (received > 0)
+      client.input.append(buffer.data(), received);
+    else if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    else if (received < 0 && errno == EINTR)
+      continue;
+    else
+      client.hangup = true;
+  }
+  if (client.input.size() > max_line &&
+      client.input.find('\n') == std::string::npos) {
+    Protocol::append_lines(client.output, Protocol::error,
+                           "Línea demasiado larga");
+    client.output += Protocol::failed;
+    client.output += '\n';
+    client.input.clear();
+    client.hangup = true;
+  }
+  dispatch(client);
+}
+
+void Server::write_client(Client& client) {
+  while (!client.output.empty()) {
+    auto sent = send(client.fd, client.output.data(), client.output.size(),
+                     MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent >= 0)
+      client.output.erase(0, sent);
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return;
+    else if (errno != EINTR) {
+      // El cliente se fue, lo que quedaba por responder se descarta
+      client.output.clear();
+      client.input.clear();
+      client.hangup = true;
+    }
+  }
+}
+
+void Server::dispatch(Client& client) {
+  if (client.busy)
+    return;
+  auto end = client.input.find('\n');
+  if (end == std::string::npos && !(client.hangup && !client.input.empty()))
+    return;
+  // Al cerrar, lo que quedó sin salto de línea es la última sentencia
+  auto line = client.input.substr(0, end);
+  client.input.erase(0, end == std::string::npos ? end : end + 1);
+  if (line.ends_with('\r'))
+    line.pop_back();
+  client.busy = true;
+  {
+    std::lock_guard lock(jobs_mutex);
+    jobs.push_back({client.fd, &client.session, std::move(line)});
+  }
+  jobs_ready.notify_one();
+}
+
+void Server::watch(Client& client) {
+  std::uint32_t wanted =
+      (client.hangup ? 0u : static_cast<std::uint32_t>(EPOLLIN)) |
+      (client.output.empty() ? 0u : static_cast<std::uint32_t>(EPOLLOUT));
+  epoll_event event{wanted, {.fd = client.fd}};
+  if (wanted == 0) {
+    // Sin nada que esperar se quita de epoll: si el cliente cerró su
+    // extremo, EPOLLHUP se informaría sin pausa
+    if (client.watched)
+      check(epoll_ctl(epoll, EPOLL_CTL_DEL, client.fd, nullptr), "epoll_ctl");
+    client.watched = false;
+    return;
+  }
+  check(epoll_ctl(epoll, client.watched ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+                  client.fd, &event),
+        "epoll_ctl");
+  client.watched = true;
+}
+
+void Server::finish_jobs() {
+  std::uint64_t ignored;
+  (void)read(wakeup, &ignored, sizeof(ignored));
+  std::vector<Done> finished;
+  {
+    std::lock_guard lock(done_mutex);
+    finished.swap(done);
+  }
+  for (auto& [fd, response] : finished) {
+    auto& client = clients.at(fd);
+    client.busy = false;
+    client.output += response;
+    write_client(client);
+    dispatch(client);
+    watch(client);
+    release(fd);
+  }
+}
+
+void Server::release(int fd) {
+  auto it = clients.find(fd);
+  auto& client = it->second;
+  if (!client.hangup || client.busy || !client.output.empty())
+    return;
+  if (client.watched)
+    epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  clients.erase(it);
+}
+
+void Server::work(std::stop_token stop) {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock lock(jobs_mutex);
+      if (!jobs_ready.wait(lock, stop, [this] {
+            return !jobs.empty();
+          }))
+        return;
+      job = std::move(jobs.front());
+      jobs.pop_front();
+    }
+    auto result = capture_command(job.line, [&](std::ostream& out) {
+      run_shared(job.line, *job.session, out);
+    });
+    std::string response;
+    Protocol::append_lines(response, Protocol::output, result.output);
+    Protocol::append_lines(response, Protocol::notice, result.notices);
+    Protocol::append_lines(response, Protocol::error, result.errors);
+    response += result.failed ? Protocol::failed : Protocol::ok;
+    response += '\n';
+    {
+      std::lock_guard lock(done_mutex);
+      done.push_back({job.client, std::move(response)});
+    }
+    std::uint64_t one = 1;
+    (void)write(wakeup, &one, sizeof(one));
+  }
+}
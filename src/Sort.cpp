@@ -0,0 +1,205 @@
+#include "Sort.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+void write_big_endian(std::uint64_t value, char* key) {
+  for (int i = sizeof(value) - 1; i >= 0; i--) {
+    key[i] = static_cast<char>(value & 0xFF);
+    value >>= 8;
+  }
+}
+} // namespace
+
+void normalize_key(const char* field, Db::Type type, bool descending,
+                   char* key) {
+  switch (type) {
+  case Db::Type::Int: {
+    // Invertir el bit de signo deja los negativos antes que los positivos
+    std::uint64_t bits;
+    std::memcpy(&bits, field, sizeof(bits));
+    write_big_endian(bits ^ (1ull << 63), key);
+    break;
+  }
+  case Db::Type::Float: {
+    // Los negativos se invierten completos para que crezcan al revés
+    std::uint64_t bits;
+    std::memcpy(&bits, field, sizeof(bits));
+    bits = (bits >> 63) ? ~bits : bits | (1ull << 63);
+    write_big_endian(bits, key);
+    break;
+  }
+  case Db::Type::Bool:
+    *key = *field;
+    break;
+  case Db::Type::String:
+    std::memcpy(key, field, Db::size_of_type(type));
+    break;
+  }
+
+  if (descending)
+    for (auto i = 0uz; i < Db::size_of_type(type); i++)
+      key[i] = ~key[i];
+}
+
+ExternalSorter::ExternalSorter(std::size_t _key_size, std::size_t record_size,
+                               std::size_t _memory_budget) :
+    key_size{_key_size},
+    entry_size{_key_size + record_size},
+    memory_budget{_memory_budget} {}
+
+ExternalSorter::~ExternalSorter() {
+  for (auto run : runs)
+    free_spill(run);
+}
+
+void ExternalSorter::add(const char* key, const char* record) {
+  if (!buffer.empty() && buffer.size() + entry_size > memory_budget)
+    spill_buffer();
+  buffer.insert(buffer.end(), key, key + key_size);
+  buffer.insert(buffer.end(), record, record + entry_size - key_size);
+}
+
+void ExternalSorter::sort_buffer() {
+  sorted.clear();
+  for (auto offset = 0uz; offset < buffer.size(); offset += entry_size)
+    sorted.push_back(buffer.data() + offset);
+  std::ranges::sort(sorted, [this](const char* a, const char* b) {
+    return std::memcmp(a, b, key_size) < 0;
+  });
+}
+
+void ExternalSorter::spill_buffer() {
+  sort_buffer();
+  SpillWriter writer(entry_size);
+  for (auto entry : sorted)
+    writer.write(entry);
+  runs.push_back(writer.finish());
+  buffer.clear();
+  sorted.clear();
+}
+
+void ExternalSorter::open_cursors(std::span<const Address> inputs) {
+  cursors.clear();
+  heap.clear();
+  for (auto run : inputs) {
+    SpillReader reader(run, entry_size);
+    auto entry = reader.next();
+    cursors.push_back({std::move(reader), entry});
+    if (entry)
+      heap.push_back(cursors.size() - 1);
+  }
+  advance = cursors.size();
+  std::ranges::make_heap(heap, std::greater<>{}, [this](std::size_t idx) {
+    return std::string_view(cursors[idx].entry, key_size);
+  });
+}
+
+const char* ExternalSorter::next_entry() {
+  auto key_of = [this](std::size_t idx) {
+    return std::string_view(cursors[idx].entry, key_size);
+  };
+  // La entrada anterior debía seguir siendo válida hasta ahora,
+  // recién se puede avanzar la corrida de la que salió
+  if (advance < cursors.size()) {
+    auto& cursor = cursors[advance];
+    cursor.entry = cursor.reader.next();
+    if (cursor.entry) {
+      heap.push_back(advance);
+      std::ranges::push_heap(heap, std::greater<>{}, key_of);
+    }
+    advance = cursors.size();
+  }
+
+  if (heap.empty())
+    return nullptr;
+  std::ranges::pop_heap(heap, std::greater<>{}, key_of);
+  advance = heap.back();
+  heap.pop_back();
+  return cursors[advance].entry;
+}
+
+// Las corridas de entrada se liberan a medida que se leen
+Address ExternalSorter::merge_runs(std::span<const Address> inputs) {
+  open_cursors(inputs);
+  SpillWriter writer(entry_size);
+  while (auto entry = next_entry())
+    writer.write(entry);
+  cursors.clear();
+  return writer.finish();
+}
+
+void ExternalSorter::finish() {
+  if (runs.empty()) {
+    sort_buffer();
+    return;
+  }
+  if (!buffer.empty())
+    spill_buffer();
+  std::vector<char>().swap(buffer);
+
+  // Cada corrida abierta fija un bloque, se deja espacio
+  // para la corrida de salida y para buscar sectores libres
+  constexpr auto fan_in = BufferManager::capacity - 2uz;
+  while (runs.size() > fan_in) {
+    std::vector<Address> inputs(runs.begin(), runs.begin() + fan_in);
+    runs.erase(runs.begin(), runs.begin() + fan_in);
+    runs.push_back(merge_runs(inputs));
+  }
+  open_cursors(runs);
+  runs.clear();
+}
+
+const char* ExternalSorter::next() {
+  if (cursors.empty())
+    return sorted_idx < sorted.size() ? sorted[sorted_idx++] + key_size
+                                      : nullptr;
+  auto entry = next_entry();
+  return entry ? entry + key_size : nullptr;
+}
+
+TopNHeap::TopNHeap(std::size_t _key_size, std::size_t record_size,
+                   std::size_t _limit) :
+    key_size{_key_size},
+    entry_size{_key_size + record_size},
+    limit{_limit} {
+  entries.reserve(limit * entry_size);
+  heap.reserve(limit);
+}
+
+void TopNHeap::add(const char* key, const char* record) {
+  // El tope del heap es la mayor clave conservada
+  auto key_of = [this](std::size_t offset) {
+    return std::string_view(entries.data() + offset, key_size);
+  };
+
+  std::size_t offset;
+  if (heap.size() < limit) {
+    offset = entries.size();
+    entries.resize(offset + entry_size);
+  } else {
+    if (limit == 0 || key_of(heap.front()) <= std::string_view(key, key_size))
+      return;
+    std::ranges::pop_heap(heap, std::less<>{}, key_of);
+    offset = heap.back();
+    heap.pop_back();
+  }
+
+  std::memcpy(entries.data() + offset, key, key_size);
+  std::memcpy(entries.data() + offset + key_size, record,
+              entry_size - key_size);
+  heap.push_back(offset);
+  std::ranges::push_heap(heap, std::less<>{}, key_of);
+}
+
+void TopNHeap::finish() {
+  std::ranges::sort_heap(heap, std::less<>{}, [this](std::size_t offset) {
+    return std::string_view(entries.data() + offset, key_size);
+  });
+}
+
+const char* TopNHeap::next() {
+  if (heap_idx == heap.size())
+    return nullptr;
+  return entries.data() + heap[heap_idx++] + key_size;
+}
@@ -0,0 +1,63 @@
+#include "Spill.hpp"
+#include <cstring>
+#include <stdexcept>
+
+SpillWriter::SpillWriter(std::size_t _entry_size) :
+    entry_size{_entry_size},
+    entries_per_sector{spill_entries_per_sector(_entry_size)} {
+  if (entries_per_sector == 0)
+    throw std::length_error("Entry does not fit in a sector");
+}
+
+void SpillWriter::write(const char* entry) {
+  if (sector.get() == NullAddress ||
+      sector.record_count() == entries_per_sector) {
+    auto next_sector = new_handle<false>();
+    if (sector.get() == NullAddress)
+      first_address = next_sector.get();
+    else
+      sector.next_sector() = next_sector.get();
+    sector = std::move(next_sector);
+    sector.next_sector() = NullAddress;
+    sector.record_count() = 0;
+  }
+
+  std::memcpy(sector.spill_entry(sector.record_count(), entry_size), entry,
+              entry_size);
+  sector.record_count()++;
+}
+
+Address SpillWriter::finish() {
+  sector = SectorHandle<false>();
+  return first_address;
+}
+
+SpillReader::SpillReader(Address first_address, std::size_t _entry_size) :
+    entry_size{_entry_size},
+    sector{first_address} {}
+
+SpillReader::~SpillReader() {
+  auto address = sector.get();
+  sector = SectorHandle<>();
+  free_spill(address);
+}
+
+const char* SpillReader::next() {
+  while (sector.get() != NullAddress && entry_idx == sector.record_count()) {
+    auto next_address = sector.next_sector();
+    free_sector(sector.get());
+    sector = SectorHandle<>(next_address);
+    entry_idx = 0;
+  }
+  if (sector.get() == NullAddress)
+    return nullptr;
+  return sector.spill_entry(entry_idx++, entry_size);
+}
+
+void free_spill(Address first_address) {
+  while (first_address != NullAddress) {
+    auto next_address = SectorHandle<>(first_address).next_sector();
+    free_sector(first_address);
+    first_address = next_address;
+  }
+}
@@ -0,0 +1,224 @@
+#include "Statement.hpp"
+#include "Errors.hpp"
+#include "Metrics.hpp"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace {
+// Separa las cláusulas finales (ORDER BY, LIMIT) del resto de la consulta
+SelectOptions take_select_options(std::string& query) {
+  SelectOptions options;
+  if (auto pos = query.rfind("LIMIT"); pos != std::string::npos) {
+    std::stringstream ss{query.substr(pos + 5)};
+    std::size_t limit;
+    if (ss >> limit) {
+      options.limit = limit;
+      query.erase(pos);
+    }
+  }
+  if (auto pos = query.rfind("ORDER BY"); pos != std::string::npos) {
+    std::stringstream ss{query.substr(pos + 8)};
+    OrderBy order_by;
+    std::string direction;
+    ss >> order_by.column >> direction;
+    order_by.descending = direction == "DESC";
+    options.order_by = std::move(order_by);
+    query.erase(pos);
+  }
+  return options;
+}
+
+// Mayor N de los marcadores $N fuera de las comillas
+std::size_t count_parameters(std::string_view expression) {
+  std::size_t count = 0;
+  bool quoted = false;
+  for (auto pos = 0uz; pos < expression.size(); pos++) {
+    if (expression[pos] == '"')
+      quoted = !quoted;
+    if (quoted || expression[pos] != '$')
+      continue;
+    std::size_t number = 0;
+    while (pos + 1 < expression.size() && std::isdigit(expression[pos + 1]))
+      number = number * 10 + (expression[++pos] - '0');
+    count = std::max(count, number);
+  }
+  return count;
+}
+} // namespace
+
+std::unique_ptr<Statement> parse_statement(std::string_view text) {
+  std::stringstream ss{std::string(text)};
+  std::string word;
+  ss >> word;
+  // EXPLAIN [ANALYZE] antepuesto a un SELECT o un DELETE
+  auto explain = Explain::None;
+  if (word == "EXPLAIN") {
+    explain = Explain::Plan;
+    ss >> word;
+    if (word == "ANALYZE") {
+      explain = Explain::Analyze;
+      ss >> word;
+    }
+    if (word != "SELECT" && word != "DELETE") {
+      errors() << "EXPLAIN solo se admite con SELECT y DELETE\n";
+      return nullptr;
+    }
+  }
+
+  auto statement = std::make_unique<Statement>();
+  std::string FROM, clause;
+  if (word == "SELECT") {
+    // * o una lista de columnas separadas por comas, sin espacios
+    std::string fields;
+    ss >> fields >> FROM >> statement->table;
+    if (fields.empty() || FROM != "FROM")
+      return nullptr;
+    std::stringstream field_list{fields};
+    for (std::string column; std::getline(field_list, column, ',');)
+      statement->options.columns.push_back(column);
+    if (fields == "*")
+      statement->options.columns.clear();
+
+    std::string rest;
+    std::getline(ss, rest, '\n');
+    auto columns = std::move(statement->options.columns);
+    statement->options = take_select_options(rest);
+    statement->options.columns = std::move(columns);
+    std::stringstream clauses{std::move(rest)};
+    std::string WHERE;
+    clauses >> WHERE;
+    if (WHERE == "JOIN") {
+      std::string ON;
+      clauses >> statement->other_table >> ON;
+      if (ON != "ON")
+        return nullptr;
+      statement->kind = Statement::Kind::Join;
+      std::getline(clauses, statement->condition, '\n');
+      if (auto pos = statement->condition.find("WHERE");
+          pos != std::string::npos) {
+        clause = statement->condition.substr(pos + 5);
+        statement->condition.erase(pos);
+      }
+    } else if (WHERE == "WHERE")
+      std::getline(clauses, clause, '\n');
+  } else if (word == "DELETE") {
+    std::string WHERE;
+    ss >> FROM >> statement->table >> WHERE;
+    if (FROM != "FROM" || WHERE != "WHERE")
+      return nullptr;
+    statement->kind = Statement::Kind::Delete;
+    std::getline(ss, clause, '\n');
+  } else
+    return nullptr;
+  statement->options.explain = explain;
+
+  std::vector<Db::Schema> schemas;
+  for (const auto& name : {statement->table, statement->other_table}) {
+    if (name.empty())
+      continue;
+    auto columns = table_columns(name);
+    if (!columns) {
+      errors() << "Tabla " << name << " no existe\n";
+      return nullptr;
+    }
+    statement->columns.push_back(std::move(*columns));
+  }
+  schemas.push_back({statement->table, statement->columns[0]});
+  if (statement->kind == Statement::Kind::Join)
+    schemas.push_back({statement->other_table, statement->columns[1]});
+
+  statement->parameter_count = count_parameters(clause);
+  if (clause.find_first_not_of(' ') != std::string::npos)
+    statement->predicate =
+        Db::parseExpression(clause, schemas, &statement->parameters);
+  else if (statement->kind == Statement::Kind::Delete)
+    return nullptr;
+  return statement;
+}
+
+bool bind_parameters(Statement& statement, std::string_view values) {
+  Db::Parameters parameters;
+  bool quoted = false;
+  std::size_t start = 0;
+  for (auto pos = 0uz; pos <= values.size(); pos++) {
+    if (pos < values.size() && values[pos] == '"')
+      quoted = !quoted;
+    if (pos < values.size() && (quoted || values[pos] != ','))
+      continue;
+    auto value = values.substr(start, pos - start);
+    start = pos + 1;
+    if (value.find_first_not_of(' ') == std::string_view::npos &&
+        parameters.empty() && pos == values.size())
+      break;
+    parameters.push_back(Db::parseLiteral(value));
+  }
+
+  if (parameters.size() != statement.parameter_count) {
+    errors() << "Se esperaban " << statement.parameter_count
+             << " parámetros y se recibieron " << parameters.size() << '\n';
+    return false;
+  }
+  statement.parameters = std::move(parameters);
+  return true;
+}
+
+void execute(const Statement& statement, std::ostream& out) {
+  switch (statement.kind) {
+  case Statement::Kind::Select:
+    select_where(statement.table, statement.predicate.get(), statement.options,
+                 out);
+    break;
+  case Statement::Kind::Join:
+    select_join(statement.table, statement.other_table, statement.condition,
+                statement.predicate.get(), statement.options, out);
+    break;
+  case Statement::Kind::Delete:
+    delete_where(statement.table, *statement.predicate,
+                 statement.options.explain, out);
+    break;
+  }
+}
+
+std::string normalize_statement(std::string_view text) {
+  std::string normalized;
+  bool quoted = false;
+  for (char c : text) {
+    if (c == '"')
+      quoted = !quoted;
+    if (!quoted && std::isspace(static_cast<unsigned char>(c))) {
+      if (!normalized.empty() && normalized.back() != ' ')
+        normalized += ' ';
+      continue;
+    }
+    normalized += c;
+  }
+  if (!normalized.empty() && normalized.back() == ' ')
+    normalized.pop_back();
+  return normalized;
+}
+
+std::shared_ptr<const Statement> PlanCache::find(std::string_view key) {
+  auto it = index.find(key);
+  if (it == index.end()) {
+    metrics.plan_cache_misses.add();
+    return nullptr;
+  }
+  metrics.plan_cache_hits.add();
+  entries.splice(entries.begin(), entries, it->second);
+  return it->second->second;
+}
+
+void PlanCache::insert(std::string key,
+                       std::shared_ptr<const Statement> statement) {
+  if (auto it = index.find(key); it != index.end()) {
+    entries.erase(it->second);
+    index.erase(it);
+  }
+  if (entries.size() == capacity) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+  }
+  entries.emplace_front(std::move(key), std::move(statement));
+  index.emplace(entries.front().first, entries.begin());
+}
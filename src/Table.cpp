@@ -1,16 +1,29 @@
 #include "Table.hpp"
-#include "BufferManager.hpp"
+#include "Errors.hpp"
+#include "Explain.hpp"
 #include "Interpreter.hpp"
+#include "Metrics.hpp"
+#include "Pipeline.hpp"
+#include "Sector.hpp"
+#include "Settings.hpp"
+#include "Sort.hpp"
+#include "Transaction.hpp"
 #include "Type.hpp"
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace {
-BufferManager buffer_manager;
 template <class T>
 auto& pun_cast(T& t) {
   return reinterpret_cast<std::array<char, sizeof(T)>&>(t);
@@ -20,11 +33,6 @@ const auto& pun_cast(const T& t) {
   return reinterpret_cast<const std::array<char, sizeof(T)>&>(t);
 }
 
-struct Table {
-  Db::SmallString name;
-  Address sector;
-};
-
 std::istream& operator>>(std::istream& is, Db::Type& type) {
   static const std::map<std::string, Db::Type> typeNames = {
       {"INT", Db::Type::Int},
@@ -67,99 +75,9 @@ read_columns(std::stringstream schema) {
   return {columns, record_size};
 }
 
-template <bool Readonly = true>
-struct SectorHandle {
-  Address address;
-
-  explicit SectorHandle(Address a = NullAddress) : address(a) {
-    buffer_manager.load_sector<Readonly>(address);
-    buffer_manager.pin(address);
-  }
-
-  SectorHandle(const SectorHandle&) = delete;
-  SectorHandle(SectorHandle&& other) : address(other.address) {
-    other.address = NullAddress;
-  }
-  SectorHandle& operator=(SectorHandle&& other) {
-    if (this != &other) {
-      this->~SectorHandle();
-      new (this) SectorHandle(std::move(other));
-    }
-    return *this;
-  }
-
-  SectorHandle(SectorHandle<false>&& other)
-  requires Readonly
-      : address(other.address) {
-    other.address = NullAddress;
-  }
-
-  ~SectorHandle() {
-    if (address != NullAddress)
-      buffer_manager.unpin(address);
-  }
-
-  auto as_tables() {
-    return reinterpret_cast<std::conditional_t<Readonly, const Table*, Table*>>(
-        buffer_manager.load_sector<Readonly>(address));
-  }
-
-  Address get() {
-    return address;
-  }
-
-  auto&& next_sector() {
-    return *reinterpret_cast<
-        std::conditional_t<Readonly, const Address*, Address*>>(
-        buffer_manager.load_sector<Readonly>(address));
-  }
-
-  auto&& column_size() {
-    return *reinterpret_cast<std::conditional_t<Readonly, const int*, int*>>(
-        buffer_manager.load_sector<Readonly>(address) + sizeof(Address));
-  }
-
-  auto&& record_count() {
-    return *reinterpret_cast<std::conditional_t<Readonly, const int*, int*>>(
-        buffer_manager.load_sector<Readonly>(address) + sizeof(Address));
-  }
-
-  auto columns() {
-    return reinterpret_cast<
-        std::conditional_t<Readonly, const Db::Column*, Db::Column*>>(
-        buffer_manager.load_sector<Readonly>(address) + sizeof(Address) +
-        sizeof(int));
-  }
-
-  auto bitmap() {
-    return buffer_manager.load_sector<Readonly>(address) + sizeof(Address) +
-           sizeof(int);
-  }
-
-  auto record_data(int bitmap_size, int record_idx, int record_size) {
-    return buffer_manager.load_sector<Readonly>(address) + sizeof(Address) +
-           sizeof(int) + bitmap_size + record_idx * record_size;
-  }
-};
-
-template <bool Readonly = true>
-auto new_handle() {
-  int total_sectors = global.plates * 2 * global.tracks * global.sectors;
-  int total_blocks = total_sectors / global.block_size;
-  for (int block_idx = 0; block_idx < total_blocks; block_idx++) {
-    for (int s_offset = 0; s_offset < global.block_size; s_offset++) {
-      Address address = {block_idx * global.block_size + s_offset};
-      auto data = buffer_manager.load_sector(address);
-      auto next_address = reinterpret_cast<const Address&>(*data);
-      if (next_address.address == 0)
-        return SectorHandle<Readonly>{address};
-    }
-  }
-  throw std::bad_alloc();
-}
-
 Address search_table(std::string_view table_name) {
   auto first_sector = SectorHandle({0});
+  std::shared_lock latch(first_sector.latch());
   auto tables = first_sector.as_tables();
   int table_idx = 0;
 
@@ -182,6 +100,8 @@ Address search_table(std::string_view table_name) {
 SectorHandle<false> write_table_header(std::string_view table_name,
                                        const std::vector<Db::Column>& columns) {
   auto first_sector = SectorHandle<false>({0});
+  // La entrada del directorio se completa antes de que la vea otra sentencia
+  std::lock_guard latch(first_sector.latch());
   auto tables = first_sector.as_tables();
   int table_idx = 0;
   while (tables[table_idx].name.front() != '\0')
@@ -197,22 +117,28 @@ SectorHandle<false> write_table_header(std::string_view table_name,
   auto sector_columns = header_sector.columns();
   for (auto& column : columns)
     *(sector_columns++) = column;
+  header_sector.last_sector() = NullAddress;
+  header_sector.free_count() = 0;
 
   return header_sector;
 }
 
 void write_sector_header(SectorHandle<false>& sector, int bitmap_size) {
   auto next_sector = new_handle<false>();
-  sector.next_sector() = next_sector.get();
-
-  sector = std::move(next_sector);
-  sector.next_sector() = NullAddress;
-  sector.record_count() = 0;
-  auto bitmap = sector.bitmap();
+  next_sector.next_sector() = NullAddress;
+  next_sector.record_count() = 0;
+  auto bitmap = next_sector.bitmap();
   while (bitmap_size--) {
     *bitmap = 0;
     bitmap++;
   }
+
+  // Se enlaza ya vacío, un recorrido en curso puede llegar a él
+  {
+    std::lock_guard latch(sector.latch());
+    sector.next_sector() = next_sector.get();
+  }
+  sector = std::move(next_sector);
 }
 
 void write_record(char* record_data, std::stringstream ss,
@@ -240,7 +166,7 @@ void write_record(char* record_data, std::stringstream ss,
     }
     case Db::Type::Bool: {
       std::getline(ss, field, ',');
-      if (field == "yes")
+      if (field == "yes" || field == "true")
         *(record_data++) = 1;
       else
         *(record_data++) = 0;
@@ -251,10 +177,12 @@ void write_record(char* record_data, std::stringstream ss,
         ss >> std::quoted(field), ss.ignore(1);
       else
         std::getline(ss, field, ',');
+      static_assert(Db::size_of_type(Db::Type::String) == 64);
+      if (field.size() > Db::size_of_type(Db::Type::String))
+        throw std::length_error("Texto de más de 64 bytes: " + field);
       for (char c : field)
         *(record_data++) = c;
-      static_assert(Db::size_of_type(Db::Type::String) == 64);
-      for (int i = field.size(); i < Db::size_of_type(Db::Type::String); i++)
+      for (auto i = field.size(); i < Db::size_of_type(Db::Type::String); i++)
         *(record_data++) = '\0';
       break;
     }
@@ -262,32 +190,38 @@ void write_record(char* record_data, std::stringstream ss,
   }
 }
 
-void write_table_data(std::ifstream& file, SectorHandle<> header_sector,
-                      int records_per_sector, int record_size) {
-  int bitmap_size = (records_per_sector + 7) / 8;
+void write_table_data(std::ifstream& file, SectorHandle<false> header_sector,
+                      int sector_capacity, int record_size, Xid xid) {
+  int bitmap_size = (sector_capacity + 7) / 8;
   std::span<const Db::Column> columns(header_sector.columns(),
                                       header_sector.column_size());
 
   SectorHandle<false> sector(header_sector.get());
   write_sector_header(sector, bitmap_size);
 
-  for (std::string line; std::getline(file, line); sector.record_count()++) {
-    if (sector.record_count() == records_per_sector)
+  for (std::string line; std::getline(file, line);) {
+    if (sector.record_count() == sector_capacity)
       write_sector_header(sector, bitmap_size);
 
-    write_record(
-        sector.record_data(bitmap_size, sector.record_count(), record_size),
-        std::stringstream(std::move(line)), columns);
-    sector.bitmap()[sector.record_count() / 8] |=
-        1 << (sector.record_count() % 8);
+    int slot = sector.record_count();
+    write_record(sector.record_data(bitmap_size, slot, record_size),
+                 std::stringstream(std::move(line)), columns);
+    std::lock_guard latch(sector.latch());
+    sector.versions(bitmap_size)[slot] = {xid, 0};
+    sector.bitmap()[slot / 8] |= 1 << (slot % 8);
+    sector.record_count()++;
   }
+  header_sector.last_sector() = sector.get();
 }
 
+// Copia de la cabecera de una tabla, las columnas no apuntan al
+// buffer porque su bloque puede ser reemplazado durante un recorrido
 struct TableHeaderInfo {
   Address records_address;
   std::size_t record_size;
-  std::span<const Db::Column> columns;
+  std::vector<Db::Column> columns;
   int bitmap_size;
+  Address header_address;
 };
 
 TableHeaderInfo read_table_header(std::string_view table_name) {
@@ -295,205 +229,999 @@ TableHeaderInfo read_table_header(std::string_view table_name) {
   if (header_sector == NullAddress)
     throw std::exception();
 
-  auto header_data = buffer_manager.load_sector(header_sector);
-  auto records_address = reinterpret_cast<const Address&>(*header_data);
-  header_data += sizeof(Address);
-  int columns_size = reinterpret_cast<const int&>(*header_data);
-  header_data += sizeof(columns_size);
-
-  auto columns = reinterpret_cast<const Db::Column*>(header_data);
+  SectorHandle header(header_sector);
+  std::shared_lock latch(header.latch());
+  auto records_address = header.next_sector();
+  std::size_t columns_size = header.column_size();
+  auto columns = header.columns();
   auto record_size = 0uz;
   for (auto idx = 0uz; idx < columns_size; idx++)
     record_size += Db::size_of_type(columns[idx].type);
 
-  int records_per_sector = 8 * (global.bytes - sizeof(Address) - sizeof(int)) /
-                           (8 * record_size + 1);
-  int bitmap_size = (records_per_sector + 7) / 8;
   return {records_address,
           record_size,
-          {columns, static_cast<std::size_t>(columns_size)},
-          bitmap_size};
+          {columns, columns + columns_size},
+          bitmap_size(record_size),
+          header_sector};
 }
 
-template <bool Readonly = true, class Visitor>
-void visit_records(Address records_address, int bitmap_size, int record_size,
-                   Visitor&& v) {
-  while (records_address != NullAddress) {
-    auto sector = SectorHandle<Readonly>({records_address});
-    auto record_count = sector.record_count();
+// Columna del ORDER BY y su posición dentro del registro
+struct SortKey {
+  std::size_t offset;
+  Db::Type type;
+  bool descending;
+};
+
+std::optional<SortKey> find_sort_key(const OrderBy& order_by,
+                                     std::span<const Db::Schema> schemas,
+                                     std::span<const Db::Column> columns) {
+  auto idx = Db::findColumn(schemas, order_by.column);
+  if (!idx)
+    return std::nullopt;
+  std::size_t offset = 0;
+  for (const auto& column : columns.first(*idx))
+    offset += size_of_type(column.type);
+  return SortKey{offset, columns[*idx].type, order_by.descending};
+}
+
+struct AllRecords {
+  bool operator()(const char*) const {
+    return true;
+  }
+};
 
-    for (auto record_idx = 0uz; record_idx < record_count; record_idx++) {
-      auto data = sector.record_data(bitmap_size, record_idx, record_size);
-      v(data, record_idx, sector.bitmap());
+// Productor de los registros de una tabla visibles en la instantánea que
+// cumplen el filtro, uno lote por sector. El filtro va fusionado con el
+// recorrido para no entregar lotes que se descartarían en la etapa
+// siguiente. Los registros visibles no cambian mientras dura la
+// instantánea, así que se pueden leer sin el latch del sector
+template <class Filter = AllRecords>
+auto scan_operator(const TableHeaderInfo& header_info,
+                   const Snapshot& snapshot, QueryPlan& plan,
+                   std::size_t stage, Filter selected = {}) {
+  return [&header_info, &snapshot, selected, &plan, stage](auto&& consume) {
+    StageScope scope(plan, stage);
+    LatencyTimer timer(metrics.scan_latency);
+    auto& counters = plan[stage];
+    auto examined_before = counters.rows_examined;
+    std::vector<const char*> batch;
+    for (auto address = header_info.records_address; address != NullAddress;) {
+      SectorHandle sector(address);
+      counters.sectors++;
+      batch.clear();
+      {
+        std::shared_lock latch(sector.latch());
+        auto bitmap = sector.bitmap();
+        auto versions = sector.versions(header_info.bitmap_size);
+        auto first = sector.record_data(header_info.bitmap_size, 0,
+                                        header_info.record_size);
+        for (int record_idx = 0; record_idx < sector.record_count();
+             record_idx++) {
+          if (!((bitmap[record_idx / 8] >> (record_idx % 8)) & 1) ||
+              !snapshot.visible(versions[record_idx]))
+            continue;
+          counters.rows_examined++;
+          auto record = first + record_idx * header_info.record_size;
+          if (selected(record))
+            batch.push_back(record);
+        }
+        address = sector.next_sector();
+      }
+      counters.rows_emitted += batch.size();
+      if (!batch.empty() && !consume(RecordBatch{sector.get(), batch}))
+        break;
     }
+    metrics.rows_scanned.add(counters.rows_examined - examined_before);
+  };
+}
+
+std::string describe_predicate(const Db::Node& predicate,
+                               std::span<const Db::Column> columns) {
+  std::ostringstream oss;
+  predicate.print(oss, columns.data());
+  return std::move(oss).str();
+}
 
-    records_address = sector.next_sector();
+// Etapa del plan para el recorrido secuencial de una tabla
+std::size_t plan_scan(QueryPlan& plan, std::string_view table_name,
+                      const TableHeaderInfo& header_info,
+                      const Db::Node* predicate = nullptr) {
+  auto stage = plan.add("Recorrido secuencial de " + std::string(table_name));
+  plan[stage].details.push_back(
+      "Registros de " + std::to_string(header_info.record_size) +
+      " bytes, " +
+      std::to_string(records_per_sector(header_info.record_size)) +
+      " por sector");
+  if (predicate)
+    plan[stage].details.push_back(
+        "Filtro: " + describe_predicate(*predicate, header_info.columns));
+  return stage;
+}
+
+// Imprime los registros que produce source, si hay ORDER BY se pasan
+// antes por un ordenamiento externo, o por un heap de tamaño acotado
+// si además hay un LIMIT que cabe en memoria, y si se pidieron columnas
+// se proyectan al final. input es la etapa del plan que produce las
+// filas; con EXPLAIN se imprime el plan en vez de los registros
+template <class Source>
+void emit_records(std::span<const Db::Schema> schemas,
+                  std::span<const Db::Column> columns, std::size_t record_size,
+                  const SelectOptions& options, Source source, QueryPlan& plan,
+                  std::size_t input, std::ostream& out) {
+  std::optional<SortKey> sort_key;
+  if (options.order_by) {
+    sort_key = find_sort_key(*options.order_by, schemas, columns);
+    if (!sort_key) {
+      errors() << "Columna " << options.order_by->column << " no existe\n";
+      return;
+    }
+  }
+
+  std::vector<std::size_t> projected;
+  std::vector<Db::Column> output_columns;
+  for (const auto& name : options.columns) {
+    auto idx = Db::findColumn(schemas, name);
+    if (!idx) {
+      errors() << "Columna " << name << " no existe\n";
+      return;
+    }
+    projected.push_back(*idx);
+    output_columns.push_back(columns[*idx]);
+  }
+
+  auto key_size = sort_key ? size_of_type(sort_key->type) : 0;
+  auto entry_size = key_size + record_size;
+  bool top_n = options.limit &&
+               *options.limit <= settings.work_memory / entry_size;
+  if (sort_key) {
+    auto order = options.order_by->column +
+                 (options.order_by->descending ? " DESC" : "");
+    input = plan.add(top_n ? "Top-N heap por " + order
+                           : "Ordenamiento externo por " + order,
+                     {input});
+    plan[input].details.push_back(
+        top_n ? "Conserva las " + std::to_string(*options.limit) +
+                    " primeras filas en memoria"
+              : "work_memory: " + std::to_string(settings.work_memory) +
+                    " bytes, fusión de hasta " +
+                    std::to_string(BufferManager::capacity - 2) + " runs");
+  }
+  auto sort_stage = input;
+  if (!projected.empty()) {
+    std::string names;
+    for (const auto& name : options.columns)
+      names += (names.empty() ? "" : ", ") + name;
+    input = plan.add("Proyección", {input});
+    plan[input].details.push_back("Columnas: " + names);
+  }
+  auto project_stage = input;
+  auto output_stage = plan.add("Salida", {input});
+  if (options.limit)
+    plan[output_stage].details.push_back(
+        "Límite: " + std::to_string(*options.limit) +
+        (sort_key ? "" : ", el recorrido se detiene al alcanzarlo"));
+
+  OutputSink output(out, projected.empty() ? columns : output_columns, plan,
+                    output_stage, options.limit.value_or(SIZE_MAX));
+  auto run = [&](auto&& input_source) {
+    if (projected.empty())
+      input_source(output);
+    else
+      project_operator(std::ref(input_source), Projection(columns, projected),
+                       plan, project_stage)(output);
+  };
+
+  // El ordenamiento es una etapa bloqueante: consume toda su entrada y
+  // recién entonces produce, de a un registro
+  auto sorted = [&](auto& sorter) {
+    return [&](auto&& consume) {
+      std::array<char, Db::size_of_type(Db::Type::String)> key;
+      source([&](const RecordBatch& batch) {
+        StageScope scope(plan, sort_stage);
+        plan[sort_stage].rows_examined += batch.records.size();
+        for (auto record : batch.records) {
+          normalize_key(record + sort_key->offset, sort_key->type,
+                        sort_key->descending, key.data());
+          sorter.add(key.data(), record);
+        }
+        return true;
+      });
+
+      StageScope scope(plan, sort_stage);
+      sorter.finish();
+      while (auto record = sorter.next()) {
+        plan[sort_stage].rows_emitted++;
+        if (!consume(RecordBatch{NullAddress, {&record, 1}}))
+          break;
+      }
+    };
+  };
+
+  if (plan.executes() && options.limit != 0) {
+    if (!sort_key) {
+      run(source);
+    } else if (top_n) {
+      TopNHeap heap(key_size, record_size, *options.limit);
+      run(sorted(heap));
+    } else {
+      ExternalSorter sorter(key_size, record_size, settings.work_memory);
+      run(sorted(sorter));
+    }
+  }
+
+  if (plan.explaining())
+    plan.print(out);
+}
+
+template <class Filter>
+void select_records(std::string_view table_name,
+                    const TableHeaderInfo& header_info,
+                    const Snapshot& snapshot, const SelectOptions& options,
+                    std::ostream& out, Filter selected,
+                    const Db::Node* predicate = nullptr) {
+  const Db::Schema schema{table_name, header_info.columns};
+  QueryPlan plan(options.explain);
+  auto scan_stage = plan_scan(plan, table_name, header_info, predicate);
+  emit_records(
+      {&schema, 1}, header_info.columns, header_info.record_size, options,
+      scan_operator(header_info, snapshot, plan, scan_stage, selected), plan,
+      scan_stage, out);
+}
+
+// Lado de un join: la tabla y la columna por la que se une
+struct JoinSide {
+  TableHeaderInfo header_info;
+  std::size_t key_offset;
+};
+
+Address next_sector_of(Address address) {
+  SectorHandle sector(address);
+  std::shared_lock latch(sector.latch());
+  return sector.next_sector();
+}
+
+// Recorre las cadenas de ambas tablas a la vez hasta que una termina,
+// así el costo es proporcional a la tabla más pequeña
+bool has_fewer_sectors(Address records, Address other_records) {
+  while (records != NullAddress && other_records != NullAddress) {
+    records = next_sector_of(records);
+    other_records = next_sector_of(other_records);
   }
+  return records == NullAddress;
+}
+
+// Hash join: construye una tabla hash con la clave del lado más pequeño
+// y la consulta mientras recorre el otro. Si el lado de construcción no
+// cabe en work_memory ambos lados se particionan por hash en sectores
+// temporales (Grace) y se une cada par de particiones por separado
+class HashJoin {
+  // Cada partición abierta fija un sector, igual que el recorrido
+  static constexpr auto partitions = BufferManager::capacity - 2uz;
+
+  const JoinSide& build;
+  const JoinSide& probe;
+  const Snapshot& snapshot;
+  bool build_is_left;
+  Db::Type key_type;
+  std::size_t key_size;
+  std::vector<char> combined;
+
+  QueryPlan& plan;
+  std::size_t stage;
+
+  std::vector<char> arena;
+  std::unordered_multimap<std::string_view, std::size_t> table;
+
+  std::size_t partition_of(const char* key) const {
+    return std::hash<std::string_view>{}({key, key_size}) % partitions;
+  }
+
+  void index_arena() {
+    auto entry_size = key_size + build.header_info.record_size;
+    table.clear();
+    table.reserve(arena.size() / entry_size);
+    for (auto offset = 0uz; offset < arena.size(); offset += entry_size)
+      table.emplace(std::string_view(arena.data() + offset, key_size),
+                    offset + key_size);
+  }
+
+  // Une el registro del lado de prueba con cada registro del lado de
+  // construcción con la misma clave, entregando cada combinación
+  // como un lote propio
+  template <class Emit>
+  bool probe_record(const char* key, const char* record, Emit& emit) {
+    auto [first, last] = table.equal_range({key, key_size});
+    auto left_size = build_is_left ? build.header_info.record_size
+                                   : probe.header_info.record_size;
+    for (auto it = first; it != last; it++) {
+      auto build_record = arena.data() + it->second;
+      auto left = build_is_left ? build_record : record;
+      auto right = build_is_left ? record : build_record;
+      std::memcpy(combined.data(), left, left_size);
+      std::memcpy(combined.data() + left_size, right,
+                  combined.size() - left_size);
+      plan[stage].rows_emitted++;
+      const char* output = combined.data();
+      if (!emit(RecordBatch{NullAddress, {&output, 1}}))
+        return false;
+    }
+    return true;
+  }
+
+  // Las filas de cada lado llegan desde su etapa de recorrido, que es
+  // la entrada correspondiente de la etapa del join
+  template <class Visitor>
+  void visit_side(const JoinSide& side, Visitor&& v) {
+    const auto& header_info = side.header_info;
+    auto input = plan[stage].inputs[&side == &build ? 0 : 1];
+    std::array<char, Db::size_of_type(Db::Type::String)> key;
+    scan_operator(header_info, snapshot, plan,
+                  input)([&](const RecordBatch& batch) {
+      StageScope scope(plan, stage);
+      for (auto record : batch.records) {
+        plan[stage].rows_examined++;
+        normalize_key(record + side.key_offset, key_type, false, key.data());
+        if (!v(key.data(), record))
+          return false;
+      }
+      return true;
+    });
+  }
+
+  // Particiona un lado completo en sectores temporales
+  std::vector<Address> partition_side(const JoinSide& side) {
+    auto entry_size = key_size + side.header_info.record_size;
+    std::vector<SpillWriter> writers;
+    for (auto p = 0uz; p < partitions; p++)
+      writers.emplace_back(entry_size);
+
+    std::vector<char> entry(entry_size);
+    visit_side(side, [&](const char* key, const char* record) {
+      std::memcpy(entry.data(), key, key_size);
+      std::memcpy(entry.data() + key_size, record, entry_size - key_size);
+      writers[partition_of(key)].write(entry.data());
+      return true;
+    });
+
+    std::vector<Address> runs;
+    for (auto& writer : writers)
+      runs.push_back(writer.finish());
+    return runs;
+  }
+
+public:
+  // stage es la etapa del plan del join, con las etapas de recorrido
+  // del lado de construcción y del de prueba como entradas
+  HashJoin(const JoinSide& _build, const JoinSide& _probe,
+           const Snapshot& _snapshot, bool _build_is_left, Db::Type _key_type,
+           QueryPlan& _plan, std::size_t _stage) :
+      build{_build},
+      probe{_probe},
+      snapshot{_snapshot},
+      build_is_left{_build_is_left},
+      key_type{_key_type},
+      key_size{size_of_type(_key_type)},
+      combined(_build.header_info.record_size +
+               _probe.header_info.record_size),
+      plan{_plan},
+      stage{_stage} {}
+
+  template <class Emit>
+  void operator()(Emit&& emit) {
+    StageScope scope(plan, stage);
+    // Se intenta construir en memoria, si no alcanza se
+    // recorre de nuevo la tabla particionándola
+    bool fits = true;
+    visit_side(build, [&](const char* key, const char* record) {
+      arena.insert(arena.end(), key, key + key_size);
+      arena.insert(arena.end(), record, record + build.header_info.record_size);
+      fits = arena.size() <= settings.work_memory;
+      return fits;
+    });
+
+    if (fits) {
+      plan[stage].details.push_back("Ejecutado en memoria");
+      index_arena();
+      visit_side(probe, [&](const char* key, const char* record) {
+        return probe_record(key, record, emit);
+      });
+      return;
+    }
+
+    plan[stage].details.push_back(
+        "Ejecutado con " + std::to_string(partitions) + " particiones");
+    arena.clear();
+    auto build_runs = partition_side(build);
+    auto probe_runs = partition_side(probe);
+    auto build_entry = key_size + build.header_info.record_size;
+    auto probe_entry = key_size + probe.header_info.record_size;
+    for (auto p = 0uz; p < partitions; p++) {
+      arena.clear();
+      SpillReader build_reader(std::exchange(build_runs[p], NullAddress),
+                               build_entry);
+      while (auto entry = build_reader.next())
+        arena.insert(arena.end(), entry, entry + build_entry);
+      index_arena();
+
+      SpillReader probe_reader(std::exchange(probe_runs[p], NullAddress),
+                               probe_entry);
+      while (auto entry = probe_reader.next()) {
+        if (!probe_record(entry, entry + key_size, emit)) {
+          // El LIMIT cortó antes, se liberan las particiones sin leer
+          for (auto run : build_runs)
+            free_spill(run);
+          for (auto run : probe_runs)
+            free_spill(run);
+          return;
+        }
+      }
+    }
+  }
+};
+
+// Agrega un sector al directorio de espacio libre de la tabla, si el
+// directorio está lleno el espacio del sector solo se recupera con VACUUM
+void add_free_sector(SectorHandle<false>& header, Address sector_address) {
+  auto free_sectors = header.free_sectors();
+  auto free_end = free_sectors + header.free_count();
+  if (header.free_count() == header.free_capacity() ||
+      std::find(free_sectors, free_end, sector_address) != free_end)
+    return;
+  *free_end = sector_address;
+  header.free_count()++;
+}
+
+void remove_free_sector(SectorHandle<false>& header, Address sector_address) {
+  auto free_sectors = header.free_sectors();
+  auto free_end = free_sectors + header.free_count();
+  if (auto it = std::find(free_sectors, free_end, sector_address);
+      it != free_end) {
+    *it = *(free_end - 1);
+    header.free_count()--;
+  }
+}
+
+// Último consumidor de un DELETE: imprime los registros que recibe, los
+// marca como borrados por la transacción y anota el sector en el
+// directorio de espacio libre. El espacio se reutiliza cuando ya ninguna
+// lectura puede ver el registro. Los lotes tienen que venir directamente
+// del recorrido de la tabla, para saber de qué sector es cada registro
+class DeleteSink {
+  const TableHeaderInfo& header_info;
+  Xid xid;
+  SectorHandle<false> header;
+  std::ostream& out;
+  QueryPlan& plan;
+  std::size_t stage;
+
+public:
+  DeleteSink(const TableHeaderInfo& _header_info, Xid _xid, std::ostream& _out,
+             QueryPlan& _plan, std::size_t _stage) :
+      header_info{_header_info},
+      xid{_xid},
+      header{_header_info.header_address},
+      out{_out},
+      plan{_plan},
+      stage{_stage} {}
+
+  bool operator()(const RecordBatch& batch) {
+    StageScope scope(plan, stage);
+    SectorHandle<false> sector(batch.sector);
+    auto first = sector.record_data(header_info.bitmap_size, 0,
+                                    header_info.record_size);
+    for (auto record : batch.records) {
+      plan[stage].rows_examined++;
+      plan[stage].rows_emitted++;
+      if (!plan.analyzing())
+        print_record(out, record, header_info.columns);
+    }
+    {
+      std::lock_guard latch(sector.latch());
+      auto versions = sector.versions(header_info.bitmap_size);
+      for (auto record : batch.records)
+        versions[(record - first) / header_info.record_size].xmax = xid;
+    }
+    add_free_sector(header, batch.sector);
+    return true;
+  }
+};
+
+// Ubica los registros nuevos de una tabla: primero en los sectores del
+// directorio de espacio libre, luego al final del último sector de la
+// cadena y solo si no queda espacio se enlaza un sector nuevo
+class RecordInserter {
+  const TableHeaderInfo& header_info;
+  int sector_capacity;
+  Xid xid;
+  // Los borrados por transacciones menores ya no los ve nadie
+  Xid oldest = transactions.oldest();
+  SectorHandle<false> header;
+  SectorHandle<false> sector;
+
+  // Ocupa el primer espacio libre del sector actual, o el de una versión
+  // borrada que nadie ve, o devuelve -1. El registro es invisible para
+  // las lecturas hasta que la transacción se confirma, así que se puede
+  // escribir después sin el latch
+  int take_slot() {
+    if (sector.get() == NullAddress)
+      return -1;
+    std::lock_guard latch(sector.latch());
+    int record_count = sector.record_count();
+    auto bitmap = sector.bitmap();
+    auto versions = sector.versions(header_info.bitmap_size);
+    auto used = [&](int slot) {
+      return (bitmap[slot / 8] >> (slot % 8)) & 1;
+    };
+    auto dead = [&](int slot) {
+      return versions[slot].xmax != 0 && versions[slot].xmax < oldest;
+    };
+    int slot = 0;
+    while (slot < record_count && used(slot) && !dead(slot))
+      slot++;
+    if (slot == record_count) {
+      if (record_count == sector_capacity)
+        return -1;
+      sector.record_count()++;
+    } else if (used(slot))
+      metrics.versions_pruned.add();
+    versions[slot] = {xid, 0};
+    bitmap[slot / 8] |= 1 << (slot % 8);
+    return slot;
+  }
+
+public:
+  RecordInserter(const TableHeaderInfo& _header_info, Xid _xid) :
+      header_info{_header_info},
+      sector_capacity{records_per_sector(_header_info.record_size)},
+      xid{_xid},
+      header{_header_info.header_address} {}
+
+  // Copia un registro ya convertido, así uno inválido nunca ocupa lugar
+  void insert(const char* record) {
+    int slot;
+    while ((slot = take_slot()) < 0) {
+      if (sector.get() != NullAddress)
+        remove_free_sector(header, sector.get());
+
+      Address last = header.last_sector();
+      if (header.free_count() > 0)
+        sector = SectorHandle<false>(
+            header.free_sectors()[header.free_count() - 1]);
+      else if (sector.get() != last && last != NullAddress)
+        sector = SectorHandle<false>(last);
+      else {
+        sector = SectorHandle<false>(last == NullAddress ? header.get() : last);
+        write_sector_header(sector, header_info.bitmap_size);
+        header.last_sector() = sector.get();
+      }
+    }
+    std::memcpy(sector.record_data(header_info.bitmap_size, slot,
+                                   header_info.record_size),
+                record, header_info.record_size);
+  }
+};
+
+// Compacta los registros vivos al inicio de la cadena, avanzando un
+// cursor de escritura que nunca pasa al de lectura, y libera los sectores
+// que quedan vacíos al final. Los borrados se descartan y los vivos se
+// congelan: se llama sin lecturas en curso (con relocation_lock) desde
+// una escritura que todavía no escribió nada, así todas las versiones
+// ya están confirmadas. Devuelve la cantidad de sectores liberados
+int compact_records(const TableHeaderInfo& header_info) {
+  auto record_size = header_info.record_size;
+  auto bitmap_size = header_info.bitmap_size;
+  int sector_capacity = records_per_sector(record_size);
+
+  auto finish_sector = [&](SectorHandle<false>& sector, int record_count) {
+    sector.record_count() = record_count;
+    auto bitmap = sector.bitmap();
+    for (int byte = 0; byte < bitmap_size; byte++) {
+      int bits = std::clamp(record_count - byte * 8, 0, 8);
+      bitmap[byte] = static_cast<char>((1 << bits) - 1);
+    }
+  };
+
+  SectorHandle<false> write_sector(header_info.records_address);
+  int write_idx = 0;
+  for (Address read_address = header_info.records_address;
+       read_address != NullAddress;) {
+    SectorHandle<false> read_sector(read_address);
+    int record_count = read_sector.record_count();
+    for (int record_idx = 0; record_idx < record_count; record_idx++) {
+      auto bitmap = read_sector.bitmap();
+      if (!((bitmap[record_idx / 8] >> (record_idx % 8)) & 1))
+        continue;
+      if (read_sector.versions(bitmap_size)[record_idx].xmax != 0) {
+        metrics.versions_pruned.add();
+        continue;
+      }
+
+      if (write_idx == sector_capacity) {
+        finish_sector(write_sector, write_idx);
+        write_sector = SectorHandle<false>(write_sector.next_sector());
+        write_idx = 0;
+      }
+      auto source =
+          read_sector.record_data(bitmap_size, record_idx, record_size);
+      write_sector.versions(bitmap_size)[write_idx] = {0, 0};
+      auto target =
+          write_sector.record_data(bitmap_size, write_idx++, record_size);
+      if (source != target)
+        std::memmove(target, source, record_size);
+    }
+    read_address = read_sector.next_sector();
+  }
+  finish_sector(write_sector, write_idx);
+
+  // Solo el último sector puede tener espacio libre
+  SectorHandle<false> header(header_info.header_address);
+  header.last_sector() = write_sector.get();
+  header.free_count() = 0;
+
+  int freed = 0;
+  auto unused = std::exchange(write_sector.next_sector(), NullAddress);
+  while (unused != NullAddress) {
+    auto next_address = SectorHandle<>(unused).next_sector();
+    free_sector(unused);
+    unused = next_address;
+    freed++;
+  }
+  return freed;
 }
 } // namespace
 
-void load_csv(std::string_view csv_name) {
+bool load_csv(std::string_view csv_name, bool append) {
   std::ifstream file(std::string{csv_name} + ".csv");
+  // Se busca dentro de la transacción: como las escrituras van de a una,
+  // nadie más puede crear la tabla entre la búsqueda y la escritura
+  WriteTransaction transaction;
   const auto header_sector = search_table(csv_name);
 
-  if (header_sector != NullAddress)
-    return;
+  if (header_sector != NullAddress) {
+    if (!append)
+      return true;
+    auto header_info = read_table_header(csv_name);
+    RecordInserter inserter(header_info, transaction.snapshot.own);
+    std::string line, record(header_info.record_size, '\0');
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+      write_record(record.data(), std::stringstream(std::move(line)),
+                   header_info.columns);
+      inserter.insert(record.data());
+    }
+    return true;
+  }
+  // Agregar nunca crea la tabla: el servidor lo ejecuta junto a otras
+  // sentencias y crear una tabla requiere el motor en exclusiva
+  if (append) {
+    errors() << "Tabla " << csv_name << " no existe\n";
+    return false;
+  }
 
   std::string schema_str;
   std::getline(file, schema_str);
   auto [columns, record_size] =
       read_columns(std::stringstream(std::move(schema_str)));
-  int records_per_sector = 8 * (global.bytes - sizeof(Address) - sizeof(int)) /
-                           (8 * record_size + 1);
-
   auto records_start = write_table_header(csv_name, columns);
-  write_table_data(file, std::move(records_start), records_per_sector,
-                   record_size);
+  write_table_data(file, std::move(records_start),
+                   records_per_sector(record_size), record_size,
+                   transaction.snapshot.own);
+  return true;
 }
 
-void select_all(std::string_view table_name) {
+std::optional<int> insert_values(std::string_view table_name,
+                                 std::string_view values) {
+  WriteTransaction transaction;
   TableHeaderInfo header_info;
   try {
     header_info = read_table_header(table_name);
   } catch (...) {
-    std::cerr << "Tabla " << table_name << " no existe\n";
-    return;
+    errors() << "Tabla " << table_name << " no existe\n";
+    return std::nullopt;
   }
 
-  visit_records(header_info.records_address, header_info.bitmap_size,
-                header_info.record_size,
-                [columns = header_info.columns](const char* records_data,
-                                                std::size_t record_idx,
-                                                const char* bitmap) {
-                  bool bit = (bitmap[record_idx / 8] >> (record_idx % 8)) & 1;
-                  if (!bit)
-                    return;
-
-                  auto field = records_data;
-                  for (const auto& column : columns) {
-                    visit_type(field, column.type, [](auto&& arg) {
-                      if constexpr (requires { std::cout << arg; })
-                        std::cout << arg;
-                      else
-                        std::cout << arg.data();
-                    });
-                    field += size_of_type(column.type);
-                    std::cout << '#';
-                  }
-                  std::cout << '\n';
-                });
-  auto header_sector = search_table(table_name);
+  // Cada grupo entre paréntesis se convierte en una línea CSV
+  std::vector<std::string> rows;
+  bool quoted = false, inside = false;
+  for (char c : values) {
+    if (c == '"')
+      quoted = !quoted;
+    if (quoted && rows.empty()) {
+      errors() << "Texto entre comillas fuera de un registro\n";
+      return std::nullopt;
+    }
+    if (quoted || (inside && c != ')' && c != ' '))
+      rows.back() += c;
+    else if (c == '(' || c == ')') {
+      inside = c == '(';
+      if (inside)
+        rows.emplace_back();
+    }
+  }
+
+  // Se convierten todas antes de insertar: si una es inválida no se
+  // inserta ninguna
+  std::vector<std::string> records;
+  for (auto& row : rows)
+    write_record(records.emplace_back(header_info.record_size, '\0').data(),
+                 std::stringstream(std::move(row)), header_info.columns);
+
+  RecordInserter inserter(header_info, transaction.snapshot.own);
+  for (const auto& record : records)
+    inserter.insert(record.data());
+  return rows.size();
+}
+
+std::optional<std::vector<Db::Column>>
+table_columns(std::string_view table_name) {
+  try {
+    return read_table_header(table_name).columns;
+  } catch (...) {
+    return std::nullopt;
+  }
+}
+
+void select_all(std::string_view table_name, const SelectOptions& options,
+                std::ostream& out) {
+  select_where(table_name, nullptr, options, out);
+}
+
+void select_all_where(std::string_view table_name, std::string_view expression,
+                      const SelectOptions& options, std::ostream& out) {
+  auto columns = table_columns(table_name);
+  if (!columns) {
+    errors() << "Tabla " << table_name << " no existe\n";
+    return;
+  }
+  auto tree = parseExpression(expression, *columns);
+  select_where(table_name, tree.get(), options, out);
 }
 
-void select_all_where(std::string_view table_name,
-                      std::string_view expression) {
+void select_where(std::string_view table_name, const Db::Node* predicate,
+                  const SelectOptions& options, std::ostream& out) {
+  ReadTransaction transaction;
   TableHeaderInfo header_info;
   try {
     header_info = read_table_header(table_name);
   } catch (...) {
-    std::cerr << "Tabla " << table_name << " no existe\n";
+    errors() << "Tabla " << table_name << " no existe\n";
     return;
   }
 
-  auto tree = parseExpression(expression, header_info.columns);
+  const auto& snapshot = transaction.snapshot;
+  if (!predicate) {
+    select_records(table_name, header_info, snapshot, options, out,
+                   AllRecords{});
+    return;
+  }
+  select_records(
+      table_name, header_info, snapshot, options, out,
+      [predicate, columns = header_info.columns.data()](const char* record) {
+        return predicate->evaluate(record, columns).get<Db::Type::Bool>();
+      },
+      predicate);
+}
 
-  visit_records(
-      header_info.records_address, header_info.bitmap_size,
-      header_info.record_size,
-      [columns = header_info.columns, &tree](const char* records_data,
-                                             std::size_t record_idx,
-                                             const char* bitmap) {
-        bool bit = (bitmap[record_idx / 8] >> (record_idx % 8)) & 1;
-        if (!bit)
-          return;
+void select_join(std::string_view left_name, std::string_view right_name,
+                 std::string_view condition, std::string_view expression,
+                 const SelectOptions& options, std::ostream& out) {
+  std::array<std::vector<Db::Column>, 2> columns;
+  for (auto [side, table_name] : {std::pair{&columns[0], left_name},
+                                  std::pair{&columns[1], right_name}}) {
+    auto table = table_columns(table_name);
+    if (!table) {
+      errors() << "Tabla " << table_name << " no existe\n";
+      return;
+    }
+    *side = std::move(*table);
+  }
 
-        bool selected =
-            tree->evaluate(records_data, columns.data()).get<Db::Type::Bool>();
-        if (!selected)
-          return;
+  Db::NodePtr tree;
+  if (!expression.empty()) {
+    const std::array<Db::Schema, 2> schemas{
+        {{left_name, columns[0]}, {right_name, columns[1]}}};
+    tree = parseExpression(expression, schemas);
+  }
+  select_join(left_name, right_name, condition, tree.get(), options, out);
+}
 
-        auto field = records_data;
-        for (const auto& column : columns) {
-          visit_type(field, column.type, [](auto&& arg) {
-            if constexpr (requires { std::cout << arg; })
-              std::cout << arg;
-            else
-              std::cout << arg.data();
-          });
-          std::cout << '#';
-          field += size_of_type(column.type);
-        }
-        std::cout << '\n';
-      });
-  auto header_sector = search_table(table_name);
+void select_join(std::string_view left_name, std::string_view right_name,
+                 std::string_view condition, const Db::Node* predicate,
+                 const SelectOptions& options, std::ostream& out) {
+  ReadTransaction transaction;
+  std::array<JoinSide, 2> sides;
+  for (auto [side, table_name] : {std::pair{&sides[0], left_name},
+                                  std::pair{&sides[1], right_name}}) {
+    try {
+      side->header_info = read_table_header(table_name);
+    } catch (...) {
+      errors() << "Tabla " << table_name << " no existe\n";
+      return;
+    }
+  }
+
+  const auto& left_columns = sides[0].header_info.columns;
+  const auto& right_columns = sides[1].header_info.columns;
+  const std::array<Db::Schema, 2> schemas{
+      {{left_name, left_columns}, {right_name, right_columns}}};
+  std::vector<Db::Column> columns(left_columns);
+  columns.insert(columns.end(), right_columns.begin(), right_columns.end());
+
+  // Solo se aceptan equijoins entre una columna de cada tabla
+  std::string on{condition};
+  std::erase(on, ' ');
+  auto equals = on.find("==");
+  std::optional<std::size_t> left_key, right_key;
+  if (equals != std::string::npos) {
+    left_key = Db::findColumn(schemas, on.substr(0, equals));
+    right_key = Db::findColumn(schemas, on.substr(equals + 2));
+  }
+  if (!left_key || !right_key) {
+    errors() << "Condición de JOIN inválida: " << condition << '\n';
+    return;
+  }
+  if (*left_key > *right_key)
+    std::swap(left_key, right_key);
+  if (*left_key >= left_columns.size() || *right_key < left_columns.size() ||
+      columns[*left_key].type != columns[*right_key].type) {
+    errors() << "Condición de JOIN inválida: " << condition << '\n';
+    return;
+  }
+
+  for (auto [side, key] : {std::pair{&sides[0], *left_key},
+                           std::pair{&sides[1], *right_key}}) {
+    side->key_offset = 0;
+    for (const auto& column : std::span(columns).first(key))
+      side->key_offset += size_of_type(column.type);
+  }
+  sides[1].key_offset -= sides[0].header_info.record_size;
+
+  bool build_is_left = has_fewer_sectors(sides[0].header_info.records_address,
+                                         sides[1].header_info.records_address);
+  const auto& build = sides[build_is_left ? 0 : 1];
+  const auto& probe = sides[build_is_left ? 1 : 0];
+  auto build_name = build_is_left ? left_name : right_name;
+  auto probe_name = build_is_left ? right_name : left_name;
+
+  QueryPlan plan(options.explain);
+  auto build_scan = plan_scan(plan, build_name, build.header_info);
+  auto probe_scan = plan_scan(plan, probe_name, probe.header_info);
+  auto join_stage = plan.add("Hash join", {build_scan, probe_scan});
+  plan[join_stage].details = {
+      "Condición: " + on,
+      "Construcción: " + std::string(build_name) +
+          " (la tabla con menos sectores)",
+      "Si no cabe en work_memory se particionan ambos lados"};
+  HashJoin join(build, probe, transaction.snapshot, build_is_left,
+                columns[*left_key].type, plan, join_stage);
+  auto record_size =
+      sides[0].header_info.record_size + sides[1].header_info.record_size;
+
+  if (!predicate) {
+    emit_records(schemas, columns, record_size, options, std::ref(join), plan,
+                 join_stage, out);
+    return;
+  }
+
+  auto filter_stage = plan.add("Filtro", {join_stage});
+  plan[filter_stage].details.push_back(
+      describe_predicate(*predicate, columns));
+  auto selected = [predicate, &columns](const char* record) {
+    return predicate->evaluate(record, columns.data()).get<Db::Type::Bool>();
+  };
+  emit_records(schemas, columns, record_size, options,
+               filter_operator(std::ref(join), selected, plan, filter_stage),
+               plan, filter_stage, out);
 }
 
-void delete_where(std::string_view table_name, std::string_view expression) {
+void delete_where(std::string_view table_name, std::string_view expression,
+                  Explain explain, std::ostream& out) {
+  auto columns = table_columns(table_name);
+  if (!columns) {
+    errors() << "Tabla " << table_name << " no existe\n";
+    return;
+  }
+  auto tree = parseExpression(expression, *columns);
+  delete_where(table_name, *tree, explain, out);
+}
+
+void delete_where(std::string_view table_name, const Db::Node& predicate,
+                  Explain explain, std::ostream& out) {
+  std::optional<WriteTransaction> transaction(std::in_place);
   TableHeaderInfo header_info;
   try {
     header_info = read_table_header(table_name);
   } catch (...) {
-    std::cerr << "Tabla " << table_name << " no existe\n";
+    errors() << "Tabla " << table_name << " no existe\n";
+    return;
+  }
+
+  QueryPlan plan(explain);
+  auto scan_stage = plan_scan(plan, table_name, header_info, &predicate);
+  auto delete_stage = plan.add("Borrado en " + std::string(table_name),
+                               {scan_stage});
+  plan[delete_stage].details.push_back(
+      "Marca la versión del registro como borrada y anota el sector en el "
+      "directorio de espacio libre");
+  if (settings.autovacuum_fill_factor > 0)
+    plan[delete_stage].details.push_back(
+        "Autovacuum si el llenado queda bajo " +
+        std::to_string(settings.autovacuum_fill_factor));
+  if (!plan.executes()) {
+    plan.print(out);
     return;
   }
 
-  auto tree = parseExpression(expression, header_info.columns);
+  auto selected = [&predicate, columns = header_info.columns.data()](
+                      const char* record) {
+    return predicate.evaluate(record, columns).get<Db::Type::Bool>();
+  };
+  const auto& snapshot = transaction->snapshot;
+  {
+    DeleteSink sink(header_info, snapshot.own, out, plan, delete_stage);
+    scan_operator(header_info, snapshot, plan, scan_stage, selected)(sink);
+  }
+  transaction.reset();
+  const auto& scanned = plan[scan_stage];
+  auto sectors = scanned.sectors;
+  auto live_records = scanned.rows_examined - scanned.rows_emitted;
 
-  visit_records<false>(
-      header_info.records_address, header_info.bitmap_size,
-      header_info.record_size,
-      [&tree, columns = header_info.columns](
-          char* records_data, std::size_t record_idx, char* bitmap) {
-        bool bit = (bitmap[record_idx / 8] >> (record_idx % 8)) & 1;
-        if (!bit)
-          return;
+  // Autovacuum: se compacta si la tabla quedó demasiado vacía
+  double fill_factor = static_cast<double>(live_records) /
+                       (std::max(sectors, std::int64_t{1}) *
+                        records_per_sector(header_info.record_size));
+  if (sectors > 1 && fill_factor < settings.autovacuum_fill_factor) {
+    StageScope scope(plan, delete_stage);
+    // Compactar cambia registros de lugar: con lecturas en curso se deja
+    // para el próximo DELETE o VACUUM en vez de esperarlas
+    WriteTransaction vacuum;
+    if (auto relocation = transactions.relocation_lock(false)) {
+      int freed = compact_records(read_table_header(table_name));
+      plan[delete_stage].details.push_back(
+          "Autovacuum liberó " + std::to_string(freed) + " sectores");
+    } else
+      plan[delete_stage].details.push_back(
+          "Autovacuum postergado, hay lecturas en curso");
+  }
 
-        bool selected =
-            tree->evaluate(records_data, columns.data()).get<Db::Type::Bool>();
-        if (!selected)
-          return;
-        auto field = records_data;
-        for (const auto& column : columns) {
-          visit_type(field, column.type, [](auto&& arg) {
-            if constexpr (requires { std::cout << arg; })
-              std::cout << arg;
-            else
-              std::cout << arg.data();
-          });
-          std::cout << '#';
-          field += size_of_type(column.type);
-        }
-        std::cout << '\n';
-        bitmap[record_idx / 8] &= ~(1 << record_idx % 8);
-      });
+  if (plan.explaining())
+    plan.print(out);
+}
+
+int vacuum(std::string_view table_name) {
+  WriteTransaction transaction;
+  TableHeaderInfo header_info;
+  try {
+    header_info = read_table_header(table_name);
+  } catch (...) {
+    errors() << "Tabla " << table_name << " no existe\n";
+    return 0;
+  }
+  auto relocation = transactions.relocation_lock(true);
+  return compact_records(header_info);
 }
 
-void disk_info() {
-  auto total_bytes =
-      global.plates * 2 * global.tracks * global.sectors * global.bytes;
-  std::cout << "Capacidad total del disco: " << total_bytes << " bytes \n";
+void disk_info(std::ostream& out) {
+  auto total_bytes = global.total_bytes();
+  out << "Capacidad total del disco: " << total_bytes << " bytes \n";
 
-  int sectors_available = 0;
-  std::cout << "Sectores disponibles:\n";
-  int total_sectors = global.plates * 2 * global.tracks * global.sectors;
-  int total_blocks = total_sectors / global.block_size;
-  for (int block_idx = 0; block_idx < total_blocks; block_idx++) {
+  std::int64_t sectors_available = 0;
+  out << "Sectores disponibles:\n";
+  auto total_sectors = global.total_sectors();
+  auto total_blocks = total_sectors / global.block_size;
+  for (std::int64_t block_idx = 0; block_idx < total_blocks; block_idx++) {
     for (int s_offset = 0; s_offset < global.block_size; s_offset++) {
       Address address = {block_idx * global.block_size + s_offset};
-      auto data = buffer_manager.load_sector(address);
-      auto next_address = reinterpret_cast<const Address&>(*data);
-      if (next_address.address == 0) {
+      if (SectorHandle(address).next_sector().address == 0) {
         sectors_available++;
-        std::cout << address.to_path().string() << '\n';
+        out << address.to_path().string() << '\n';
       }
     }
   }
-  std::cout << "En total hay " << sectors_available
-            << " sectores disponibles\n";
-  std::cout << "En total hay " << total_sectors - sectors_available
-            << " sectores ocupados\n";
-  int free_bytes = sectors_available * global.bytes;
-  std::cout << "El disco tiene " << free_bytes << " bytes disponibles\n";
-  std::cout << "El disco tiene " << total_bytes - free_bytes
-            << " bytes ocupados\n";
+  out << "En total hay " << sectors_available << " sectores disponibles\n";
+  out << "En total hay " << total_sectors - sectors_available
+      << " sectores ocupados\n";
+  auto free_bytes = sectors_available * global.bytes;
+  out << "El disco tiene " << free_bytes << " bytes disponibles\n";
+  out << "El disco tiene " << total_bytes - free_bytes << " bytes ocupados\n";
 }
@@ -0,0 +1,150 @@
+#include "Trace.hpp"
+#include <array>
+#include <chrono>
+#include <ostream>
+
+namespace {
+// Eventos que guarda cada hilo, los más antiguos se sobrescriben
+constexpr std::size_t ring_capacity = 1 << 16;
+
+struct EventInfo {
+  std::string_view name;
+  std::string_view category;
+  char phase;
+  std::string_view argument;
+};
+
+constexpr std::array<EventInfo, 10> event_info{{
+    {"pin", "buffer", 'i', "block"},
+    {"unpin", "buffer", 'i', "block"},
+    {"hit", "buffer", 'i', "block"},
+    {"miss", "buffer", 'i', "block"},
+    {"evict", "buffer", 'i', "block"},
+    {"flush", "buffer", 'i', "block"},
+    {"sector_read", "disk", 'i', "sector"},
+    {"sector_write", "disk", 'i', "sector"},
+    {"query", "query", 'B', "sql"},
+    {"query", "query", 'E', {}},
+}};
+
+std::int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void write_escaped(std::ostream& os, std::string_view text) {
+  constexpr std::string_view hex = "0123456789abcdef";
+  for (unsigned char c : text) {
+    if (c == '"' || c == '\\')
+      os << '\\' << c;
+    else if (c < 0x20)
+      os << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+    else
+      os << c;
+  }
+}
+} // namespace
+
+struct TraceRecord {
+  std::int64_t nanoseconds;
+  std::int64_t argument;
+  TraceEvent event;
+};
+
+// Buffer circular de un hilo: solo su dueño escribe y avanza head, el
+// lector descarta lo que pudo sobrescribirse mientras copiaba
+struct TraceBuffer {
+  int thread_id;
+  std::atomic<std::uint64_t> head = 0;
+  std::array<TraceRecord, ring_capacity> records;
+};
+
+// El registro es dueño de los buffers, así siguen disponibles para el
+// volcado (y para eventos emitidos al destruir estáticos) aunque las
+// variables thread_local de su hilo ya se hayan destruido
+TraceBuffer& Tracer::local_buffer() {
+  thread_local TraceBuffer* local = [this] {
+    auto buffer = std::make_shared<TraceBuffer>();
+    std::lock_guard lock(registry_mutex);
+    buffer->thread_id = static_cast<int>(buffers.size()) + 1;
+    buffers.push_back(buffer);
+    return buffer.get();
+  }();
+  return *local;
+}
+
+void Tracer::append(TraceEvent event, std::int64_t argument) {
+  auto& buffer = local_buffer();
+  auto head = buffer.head.load(std::memory_order_relaxed);
+  buffer.records[head % ring_capacity] = {now_ns(), argument, event};
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::start() {
+  started.store(now_ns(), std::memory_order_relaxed);
+  enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop() {
+  enabled.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::begin_query(std::string_view query) {
+  std::int64_t idx;
+  {
+    std::lock_guard lock(registry_mutex);
+    idx = static_cast<std::int64_t>(queries.size());
+    queries.emplace_back(query);
+  }
+  record(TraceEvent::QueryBegin, idx);
+}
+
+// Se registra aunque el trazado se haya apagado durante la sentencia,
+// para que cada inicio tenga su fin
+void Tracer::end_query() {
+  append(TraceEvent::QueryEnd, 0);
+}
+
+void Tracer::dump(std::ostream& os) const {
+  std::lock_guard lock(registry_mutex);
+  auto since = started.load(std::memory_order_relaxed);
+  os << "{\"traceEvents\": [";
+  bool first = true;
+  for (const auto& buffer : buffers) {
+    auto head = buffer->head.load(std::memory_order_acquire);
+    auto begin = head > ring_capacity ? head - ring_capacity : 0;
+    std::vector<TraceRecord> records;
+    for (auto idx = begin; idx < head; idx++)
+      records.push_back(buffer->records[idx % ring_capacity]);
+    // Lo que el hilo alcanzó a sobrescribir durante la copia se descarta
+    auto after = buffer->head.load(std::memory_order_acquire);
+    auto overwritten =
+        after > begin + ring_capacity ? after - begin - ring_capacity : 0;
+
+    for (auto idx = overwritten; idx < records.size(); idx++) {
+      const auto& record = records[idx];
+      if (record.nanoseconds < since)
+        continue;
+      const auto& info = event_info[static_cast<std::size_t>(record.event)];
+      auto elapsed = record.nanoseconds - since;
+      os << (first ? "\n" : ",\n") << "  {\"name\": \"" << info.name
+         << "\", \"cat\": \"" << info.category << "\", \"ph\": \""
+         << info.phase << "\", \"ts\": " << elapsed / 1000 << '.'
+         << elapsed / 100 % 10 << ", \"pid\": 1, \"tid\": "
+         << buffer->thread_id;
+      first = false;
+      if (info.phase == 'i')
+        os << ", \"s\": \"t\"";
+      if (info.argument == "sql") {
+        os << ", \"args\": {\"sql\": \"";
+        write_escaped(os, queries[record.argument]);
+        os << "\"}";
+      } else if (!info.argument.empty())
+        os << ", \"args\": {\"" << info.argument << "\": " << record.argument
+           << '}';
+      os << '}';
+    }
+  }
+  os << "\n]}\n";
+}
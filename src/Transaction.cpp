@@ -0,0 +1,85 @@
+#include "Transaction.hpp"
+#include "Disk.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+fs::path xid_path() {
+  return disk_path / "xid";
+}
+} // namespace
+
+void TransactionManager::load() {
+  if (next != 0)
+    return;
+  // Un disco sin el archivo todavía no tiene versiones escritas
+  next = 1;
+  int file = ::open(xid_path().c_str(), O_RDONLY);
+  if (file < 0)
+    return;
+  Xid saved = 0;
+  if (::pread(file, &saved, sizeof(saved), 0) == sizeof(saved) && saved > 0)
+    next = saved;
+  ::close(file);
+}
+
+Snapshot TransactionManager::begin_read() {
+  std::lock_guard lock(mutex);
+  load();
+  Snapshot snapshot{next, writing, 0};
+  readers.insert(writing ? writing : next);
+  return snapshot;
+}
+
+void TransactionManager::end_read(const Snapshot& snapshot) {
+  std::lock_guard lock(mutex);
+  readers.erase(
+      readers.find(snapshot.active ? snapshot.active : snapshot.horizon));
+}
+
+Snapshot TransactionManager::begin_write() {
+  writer.lock();
+  std::lock_guard lock(mutex);
+  load();
+  writing = next++;
+  // Se guarda antes de escribir versiones con el identificador nuevo,
+  // así después de reiniciar no se vuelve a entregar
+  int file = ::open(xid_path().c_str(), O_WRONLY | O_CREAT, 0644);
+  bool saved =
+      file >= 0 && ::pwrite(file, &next, sizeof(next), 0) == sizeof(next);
+  auto error = errno;
+  if (file >= 0)
+    ::close(file);
+  if (!saved) {
+    next--;
+    writing = 0;
+    writer.unlock();
+    throw std::system_error(error, std::generic_category(), "xid");
+  }
+  return {writing, 0, writing};
+}
+
+void TransactionManager::commit(const Snapshot& snapshot) {
+  std::lock_guard lock(mutex);
+  if (writing == snapshot.own)
+    writing = 0;
+  writer.unlock();
+}
+
+Xid TransactionManager::oldest() {
+  std::lock_guard lock(mutex);
+  load();
+  Xid oldest = writing ? writing : next;
+  if (!readers.empty() && *readers.begin() < oldest)
+    oldest = *readers.begin();
+  return oldest;
+}
+
+std::unique_lock<std::shared_mutex>
+TransactionManager::relocation_lock(bool wait) {
+  if (wait)
+    return std::unique_lock(relocation);
+  return std::unique_lock(relocation, std::try_to_lock);
+}